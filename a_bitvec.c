@@ -0,0 +1,270 @@
+/*
+ * a_bitvec: a growable vector of bits.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "a_common.h"
+#include "a_bitvec.h"
+#include "a_vector.h"
+
+#if defined(__x86_64__)
+#define A_BITVEC_X86
+#include <emmintrin.h>
+#endif
+
+static inline size_t nwords(size_t nbits) { return (nbits + 63) / 64; }
+
+static a_bitvec bitvec_invalid(void) {
+    return (a_bitvec){.words = NULL, .len = (size_t)-1, .cap = (size_t)-1};
+}
+
+// clears the bits past len in the last word.
+static inline void trim_tail(a_bitvec* v) {
+    if (v->len % 64 != 0)
+        v->words[v->len / 64] &= ~0ULL >> (64 - v->len % 64);
+}
+
+static inline void check_index(const a_bitvec* v, size_t i) {
+    if (!a_bitvec_valid(v))
+        panic("cannot operate on an invalid a_bitvec!");
+    if (i >= v->len)
+        panic("bit index %zu out of range", i);
+}
+
+a_bitvec a_bitvec_new(void) { return a_bitvec_with_capacity(64); }
+
+a_bitvec a_bitvec_with_capacity(size_t nbits) {
+    a_bitvec res = {.len = 0, .cap = nwords(nbits)};
+    if (res.cap == 0)
+        res.cap = 1;
+
+    res.words = calloc(res.cap, sizeof(u64));
+    check_alloc(res.words);
+    return res;
+}
+
+a_bitvec a_bitvec_zeros(size_t nbits) {
+    a_bitvec res = a_bitvec_with_capacity(nbits);
+    res.len = nbits;
+    return res;
+}
+
+void a_bitvec_free(a_bitvec* v) {
+    if (!a_bitvec_valid(v))
+        return;
+
+    free(v->words);
+    *v = bitvec_invalid();
+}
+
+bool a_bitvec_valid(const a_bitvec* v) {
+    return !(v->len == (size_t)-1 || v->cap == (size_t)-1 || v->words == NULL);
+}
+
+void a_bitvec_reserve(a_bitvec* v, size_t nbits) {
+    if (!a_bitvec_valid(v))
+        panic("cannot operate on an invalid a_bitvec!");
+
+    size_t need = nwords(nbits);
+    if (need <= v->cap)
+        return;
+
+    size_t cap = v->cap;
+    while (cap < need)
+        cap *= A_VECTOR_GROWTH_FACTOR;
+    v->words = realloc(v->words, cap * sizeof(u64));
+    check_alloc(v->words);
+    // keep every word past the length clear, so growing never has to.
+    memset(&v->words[v->cap], 0, (cap - v->cap) * sizeof(u64));
+    v->cap = cap;
+}
+
+void a_bitvec_resize(a_bitvec* v, size_t nbits) {
+    a_bitvec_reserve(v, nbits);
+    if (nbits < v->len) {
+        size_t old_words = nwords(v->len);
+        v->len = nbits;
+        trim_tail(v);
+        size_t keep = nwords(nbits);
+        memset(&v->words[keep], 0, (old_words - keep) * sizeof(u64));
+    } else {
+        v->len = nbits;
+    }
+}
+
+void a_bitvec_append(a_bitvec* v, bool bit) {
+    a_bitvec_reserve(v, v->len + 1);
+    if (bit)
+        v->words[v->len / 64] |= 1ULL << (v->len % 64);
+    v->len++;
+}
+
+void a_bitvec_set(a_bitvec* v, size_t i) {
+    check_index(v, i);
+    v->words[i / 64] |= 1ULL << (i % 64);
+}
+
+void a_bitvec_clear(a_bitvec* v, size_t i) {
+    check_index(v, i);
+    v->words[i / 64] &= ~(1ULL << (i % 64));
+}
+
+bool a_bitvec_test(const a_bitvec* v, size_t i) {
+    check_index(v, i);
+    return (v->words[i / 64] >> (i % 64)) & 1;
+}
+
+void a_bitvec_fill(a_bitvec* v, bool bit) {
+    if (!a_bitvec_valid(v))
+        panic("cannot operate on an invalid a_bitvec!");
+
+    memset(v->words, bit ? 0xFF : 0, nwords(v->len) * sizeof(u64));
+    trim_tail(v);
+}
+
+static size_t check_pair(const a_bitvec* dst, const a_bitvec* src) {
+    if (!a_bitvec_valid(dst) || !a_bitvec_valid(src))
+        panic("cannot operate on an invalid a_bitvec!");
+    if (dst->len != src->len)
+        panic("length mismatch: %zu and %zu bits", dst->len, src->len);
+    return nwords(dst->len);
+}
+
+/*
+ * the bulk operations work on 4 words per step with SSE2, which is part of
+ * the x86-64 baseline, and on single words elsewhere.
+ */
+#ifdef A_BITVEC_X86
+#define BITVEC_BULK(name, simd, scalar)                                        \
+    void a_bitvec_##name(a_bitvec* dst, const a_bitvec* src) {                 \
+        size_t n = check_pair(dst, src);                                       \
+        u64* d = dst->words;                                                   \
+        const u64* s = src->words;                                             \
+        size_t i = 0;                                                          \
+        for (; i + 4 <= n; i += 4) {                                           \
+            __m128i a0 = _mm_loadu_si128((const __m128i*)&d[i]);               \
+            __m128i a1 = _mm_loadu_si128((const __m128i*)&d[i + 2]);           \
+            __m128i b0 = _mm_loadu_si128((const __m128i*)&s[i]);               \
+            __m128i b1 = _mm_loadu_si128((const __m128i*)&s[i + 2]);           \
+            _mm_storeu_si128((__m128i*)&d[i], simd(a0, b0));                   \
+            _mm_storeu_si128((__m128i*)&d[i + 2], simd(a1, b1));               \
+        }                                                                      \
+        for (; i < n; i++)                                                     \
+            d[i] = scalar(d[i], s[i]);                                         \
+    }
+#else
+#define BITVEC_BULK(name, simd, scalar)                                        \
+    void a_bitvec_##name(a_bitvec* dst, const a_bitvec* src) {                 \
+        size_t n = check_pair(dst, src);                                       \
+        for (size_t i = 0; i < n; i++)                                         \
+            dst->words[i] = scalar(dst->words[i], src->words[i]);              \
+    }
+#endif
+
+#define SCALAR_AND(a, b)    ((a) & (b))
+#define SCALAR_OR(a, b)     ((a) | (b))
+#define SCALAR_XOR(a, b)    ((a) ^ (b))
+#define SCALAR_ANDNOT(a, b) ((a) & ~(b))
+
+// _mm_andnot_si128 computes ~a & b, so the operands are swapped.
+#define SIMD_ANDNOT(a, b) _mm_andnot_si128((b), (a))
+
+BITVEC_BULK(and, _mm_and_si128, SCALAR_AND)
+BITVEC_BULK(or, _mm_or_si128, SCALAR_OR)
+BITVEC_BULK(xor, _mm_xor_si128, SCALAR_XOR)
+BITVEC_BULK(andnot, SIMD_ANDNOT, SCALAR_ANDNOT)
+
+/*
+ * inlined into both callers below, so that the popcounts compile to the
+ * popcnt instruction in one and to the generic fallback in the other.
+ */
+__attribute__((always_inline)) static inline size_t
+count_words(const u64* w, size_t n) {
+    // independent sums, so consecutive popcounts do not wait on each other.
+    size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        c0 += (size_t)__builtin_popcountll(w[i]);
+        c1 += (size_t)__builtin_popcountll(w[i + 1]);
+        c2 += (size_t)__builtin_popcountll(w[i + 2]);
+        c3 += (size_t)__builtin_popcountll(w[i + 3]);
+    }
+    for (; i < n; i++)
+        c0 += (size_t)__builtin_popcountll(w[i]);
+    return c0 + c1 + c2 + c3;
+}
+
+static size_t count_words_generic(const u64* w, size_t n) {
+    return count_words(w, n);
+}
+
+#ifdef A_BITVEC_X86
+__attribute__((target("popcnt"))) static size_t
+count_words_popcnt(const u64* w, size_t n) {
+    return count_words(w, n);
+}
+#endif
+
+size_t a_bitvec_count(const a_bitvec* v) {
+    if (!a_bitvec_valid(v))
+        panic("cannot operate on an invalid a_bitvec!");
+
+#ifdef A_BITVEC_X86
+    if (__builtin_cpu_supports("popcnt"))
+        return count_words_popcnt(v->words, nwords(v->len));
+#endif
+    return count_words_generic(v->words, nwords(v->len));
+}
+
+size_t a_bitvec_find_first(const a_bitvec* v) {
+    return a_bitvec_find_next(v, 0);
+}
+
+size_t a_bitvec_find_next(const a_bitvec* v, size_t from) {
+    if (!a_bitvec_valid(v))
+        panic("cannot operate on an invalid a_bitvec!");
+    if (from >= v->len)
+        return A_BITVEC_NONE;
+
+    size_t n = nwords(v->len);
+    size_t w = from / 64;
+    u64 bits = v->words[w] & (~0ULL << (from % 64));
+    while (bits == 0) {
+        if (++w >= n)
+            return A_BITVEC_NONE;
+        bits = v->words[w];
+    }
+    return w * 64 + (size_t)__builtin_ctzll(bits);
+}
+
+a_bitvec_iter a_bitvec_iter_new(const a_bitvec* v) {
+    if (!a_bitvec_valid(v))
+        panic("cannot operate on an invalid a_bitvec!");
+
+    return (a_bitvec_iter){
+        .v = v,
+        .word = 0,
+        .bits = v->len > 0 ? v->words[0] : 0,
+    };
+}
+
+bool a_bitvec_next(a_bitvec_iter* it, size_t* out) {
+    size_t n = nwords(it->v->len);
+    while (it->bits == 0) {
+        if (it->word + 1 >= n)
+            return false;
+        it->bits = it->v->words[++it->word];
+    }
+
+    *out = it->word * 64 + (size_t)__builtin_ctzll(it->bits);
+    it->bits &= it->bits - 1;
+    return true;
+}
@@ -0,0 +1,172 @@
+/*
+ * a_bitvec: a growable vector of bits.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_BITVEC_H
+#define _A_BITVEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+
+// returned by the search functions when there is no set bit.
+#define A_BITVEC_NONE ((size_t)-1)
+
+/**
+ * vector of flags, packed 64 to a word. It grows like an a_vector.
+ *
+ * bits past `len` in the last word are always kept clear, so whole words can
+ * be counted and combined without masking.
+ */
+typedef struct {
+    // the packed bits. bit i is bit (i % 64) of word (i / 64).
+    u64* words;
+
+    // number of bits.
+    size_t len;
+
+    // capacity in words.
+    size_t cap;
+} a_bitvec;
+
+/**
+ * iterator over the indices of the set bits of an a_bitvec, in increasing
+ * order. Create one with `a_bitvec_iter_new` and advance it with
+ * `a_bitvec_next`.
+ */
+typedef struct {
+    // the vector being iterated over.
+    const a_bitvec* v;
+
+    // index of the current word.
+    size_t word;
+
+    // the bits of the current word that have not been visited yet.
+    u64 bits;
+} a_bitvec_iter;
+
+/**
+ * creates an empty a_bitvec.
+ */
+a_bitvec a_bitvec_new(void);
+
+/**
+ * creates an empty a_bitvec with room for a number of bits.
+ *
+ * @param nbits the number of bits
+ */
+a_bitvec a_bitvec_with_capacity(size_t nbits);
+
+/**
+ * creates an a_bitvec of a number of clear bits.
+ *
+ * @param nbits the number of bits
+ */
+a_bitvec a_bitvec_zeros(size_t nbits);
+
+/**
+ * frees an a_bitvec.
+ */
+void a_bitvec_free(a_bitvec* v);
+
+/**
+ * checks if an a_bitvec is valid.
+ */
+bool a_bitvec_valid(const a_bitvec* v);
+
+/**
+ * makes room for at least a number of bits.
+ *
+ * @param nbits the number of bits
+ */
+void a_bitvec_reserve(a_bitvec* v, size_t nbits);
+
+/**
+ * changes the number of bits. New bits are clear.
+ *
+ * @param nbits the new number of bits
+ */
+void a_bitvec_resize(a_bitvec* v, size_t nbits);
+
+/**
+ * appends a bit.
+ */
+void a_bitvec_append(a_bitvec* v, bool bit);
+
+/**
+ * sets a bit.
+ */
+void a_bitvec_set(a_bitvec* v, size_t i);
+
+/**
+ * clears a bit.
+ */
+void a_bitvec_clear(a_bitvec* v, size_t i);
+
+/**
+ * checks if a bit is set.
+ */
+bool a_bitvec_test(const a_bitvec* v, size_t i);
+
+/**
+ * sets every bit to the same value.
+ */
+void a_bitvec_fill(a_bitvec* v, bool bit);
+
+/*
+ * bulk operations. Both vectors must have the same length, and the result is
+ * stored in `dst`.
+ */
+
+// dst = dst & src
+void a_bitvec_and(a_bitvec* dst, const a_bitvec* src);
+
+// dst = dst | src
+void a_bitvec_or(a_bitvec* dst, const a_bitvec* src);
+
+// dst = dst ^ src
+void a_bitvec_xor(a_bitvec* dst, const a_bitvec* src);
+
+// dst = dst & ~src
+void a_bitvec_andnot(a_bitvec* dst, const a_bitvec* src);
+
+/**
+ * counts the set bits.
+ */
+size_t a_bitvec_count(const a_bitvec* v);
+
+/**
+ * finds the first set bit.
+ *
+ * @return its index, or `A_BITVEC_NONE`
+ */
+size_t a_bitvec_find_first(const a_bitvec* v);
+
+/**
+ * finds the first set bit at or after an index.
+ *
+ * @param from the index to start at
+ * @return its index, or `A_BITVEC_NONE`
+ */
+size_t a_bitvec_find_next(const a_bitvec* v, size_t from);
+
+/**
+ * creates an iterator over the set bits of an a_bitvec. The vector must not
+ * be changed while it is being iterated over.
+ */
+a_bitvec_iter a_bitvec_iter_new(const a_bitvec* v);
+
+/**
+ * gets the index of the next set bit.
+ *
+ * @param out where to store the index
+ * @return false once every set bit has been visited
+ */
+bool a_bitvec_next(a_bitvec_iter* it, size_t* out);
+
+#endif // _A_BITVEC_H
@@ -56,6 +56,7 @@
 
 #define panic(...)                                                             \
     {                                                                          \
+        a_log_panic_flush(); /* queued records go out before the panic */      \
         eprintf("\033[31;1mpanic:\033[0m line `%d`, func `%s` in file `%s`: "  \
                 "`",                                                           \
                 __LINE__, __func__, __FILE__);                                 \
@@ -65,13 +66,7 @@
         exit(1);                                                               \
     }
 
-#define fatal_noexit(...)                                                      \
-    {                                                                          \
-        eprintf(S_RED S_BOLD "[fatal] " S_END);                                \
-        eprintf(S_DIM);                                                        \
-        eprintf(__VA_ARGS__);                                                  \
-        eprintf(S_END "\n");                                                   \
-    }
+#define fatal_noexit(...) a_log(A_LOG_FATAL, __VA_ARGS__)
 
 #define fatal(...)                                                             \
     {                                                                          \
@@ -79,21 +74,9 @@
         exit(1);                                                               \
     }
 
-#define warn(...)                                                              \
-    {                                                                          \
-        eprintf(S_MAGENTA S_BOLD "[warn] " S_END);                             \
-        eprintf(S_DIM);                                                        \
-        eprintf(__VA_ARGS__);                                                  \
-        eprintf(S_END "\n");                                                   \
-    }
+#define warn(...) a_log(A_LOG_WARN, __VA_ARGS__)
 
-#define info(...)                                                              \
-    {                                                                          \
-        eprintf(S_CYAN S_BOLD "[info] " S_END);                                \
-        eprintf(S_DIM);                                                        \
-        eprintf(__VA_ARGS__);                                                  \
-        eprintf(S_END "\n");                                                   \
-    }
+#define info(...) a_log(A_LOG_INFO, __VA_ARGS__)
 
 typedef size_t usize;
 typedef ssize_t isize;
@@ -107,3 +90,6 @@ typedef unsigned long long int u64;
 typedef signed long long int i64;
 typedef float f32;
 typedef double f64;
+
+// the logger behind `info`, `warn` and `fatal`.
+#include "a_log.h"
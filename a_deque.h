@@ -0,0 +1,271 @@
+/*
+ * a_deque: growable ring buffers.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_DEQUE_H
+#define _A_DEQUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a_vector.h"
+
+// smallest capacity of a deque. Capacities are always powers of 2.
+#define A_DEQUE_MIN_CAP 8
+
+/*
+ * an a_deque is a ring buffer: elements are pushed and popped at both ends
+ * in O(1) without moving the others, which makes it a FIFO that does not
+ * memmove on every dequeue like `a_vector_T_pop_at(v, 0)` does. The
+ * elements may wrap around the end of the buffer, so they are stored in up
+ * to 2 contiguous segments, which can be handed to readv/writev directly:
+ *
+ *     a_deque_u8_seg a, b;
+ *     a_deque_u8_segments(&d, &a, &b);         // the queued bytes
+ *     a_deque_u8_consume_front(&d, written);   // once they are sent
+ *
+ *     a_deque_u8_spare(&d, 4096, &a, &b);      // room for 4096 more
+ *     a_deque_u8_commit_back(&d, nread);       // once it is filled
+ *
+ * growing moves the elements into a new buffer in order, with one copy of
+ * each element.
+ *
+ *     A_DEQUE_DECL(u32);    // in a header
+ *     A_DEQUE_IMPL(u32)     // in one .c file
+ */
+#define A_DEQUE_DECL(T)                                                        \
+    typedef struct {                                                           \
+        T* data;                                                               \
+        size_t head;                                                           \
+        size_t len;                                                            \
+        size_t cap;                                                            \
+    } a_deque_##T;                                                             \
+    typedef struct {                                                           \
+        T* data;                                                               \
+        size_t len;                                                            \
+    } a_deque_##T##_seg;                                                       \
+    a_deque_##T a_deque_##T##_new(void);                                       \
+    a_deque_##T a_deque_##T##_with_capacity(size_t cap);                       \
+    a_deque_##T a_deque_##T##_from_slice(const T* slice, size_t nitems);       \
+    void a_deque_##T##_free(a_deque_##T* d);                                   \
+    bool a_deque_##T##_valid(const a_deque_##T* d);                            \
+    void a_deque_##T##_clear(a_deque_##T* d);                                  \
+    void a_deque_##T##_reserve(a_deque_##T* d, size_t cap);                    \
+    T* a_deque_##T##_at(a_deque_##T* d, size_t pos);                           \
+    void a_deque_##T##_push_back(a_deque_##T* d, T new_elem);                  \
+    void a_deque_##T##_push_front(a_deque_##T* d, T new_elem);                 \
+    T a_deque_##T##_pop_back(a_deque_##T* d);                                  \
+    T a_deque_##T##_pop_front(a_deque_##T* d);                                 \
+    void a_deque_##T##_push_back_slice(a_deque_##T* d, const T* ptr,           \
+                                       size_t nitems);                         \
+    size_t a_deque_##T##_pop_front_slice(a_deque_##T* d, T* out,               \
+                                         size_t nitems);                       \
+    void a_deque_##T##_segments(const a_deque_##T* d,                          \
+                                a_deque_##T##_seg* first,                      \
+                                a_deque_##T##_seg* second);                    \
+    void a_deque_##T##_consume_front(a_deque_##T* d, size_t nitems);           \
+    void a_deque_##T##_spare(a_deque_##T* d, size_t nitems,                    \
+                             a_deque_##T##_seg* first,                         \
+                             a_deque_##T##_seg* second);                       \
+    void a_deque_##T##_commit_back(a_deque_##T* d, size_t nitems)
+
+/*
+ * implements a deque whose elements own resources, like
+ * `A_VECTOR_IMPL_DROP`. Elements are dropped when the deque is freed or
+ * cleared and when they are consumed; popped elements belong to the caller.
+ */
+#define A_DEQUE_IMPL(T) A_DEQUE_IMPL_DROP(T, A_VECTOR_NO_DROP)
+#define A_DEQUE_IMPL_DROP(T, drop_fn)                                          \
+    a_deque_##T a_deque_##T##_new(void) {                                      \
+        return a_deque_##T##_with_capacity(A_DEQUE_MIN_CAP);                   \
+    }                                                                          \
+    a_deque_##T a_deque_##T##_with_capacity(size_t cap) {                      \
+        a_deque_##T res = {.head = 0, .len = 0, .cap = A_DEQUE_MIN_CAP};       \
+        while (res.cap < cap)                                                  \
+            res.cap *= 2;                                                      \
+        res.data = malloc(res.cap * sizeof(T));                                \
+        check_alloc(res.data);                                                 \
+        return res;                                                            \
+    }                                                                          \
+    a_deque_##T a_deque_##T##_from_slice(const T* slice, size_t nitems) {      \
+        a_deque_##T res = a_deque_##T##_with_capacity(nitems);                 \
+        memcpy(res.data, slice, nitems * sizeof(T));                           \
+        res.len = nitems;                                                      \
+        return res;                                                            \
+    }                                                                          \
+    void a_deque_##T##_free(a_deque_##T* d) {                                  \
+        if (a_deque_##T##_valid(d)) {                                          \
+            a_deque_##T##_clear(d);                                            \
+        }                                                                      \
+        free(d->data);                                                         \
+        d->data = NULL;                                                        \
+        d->head = 0;                                                           \
+        d->len = (size_t)-1;                                                   \
+        d->cap = (size_t)-1;                                                   \
+    }                                                                          \
+    bool a_deque_##T##_valid(const a_deque_##T* d) {                           \
+        return !(d->len == (size_t)-1 || d->cap == (size_t)-1 ||               \
+                 d->data == NULL);                                             \
+    }                                                                          \
+    void a_deque_##T##_clear(a_deque_##T* d) {                                 \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        for (size_t i = 0; i < d->len; i++)                                    \
+            drop_fn(&d->data[(d->head + i) & (d->cap - 1)]);                   \
+        d->head = 0;                                                           \
+        d->len = 0;                                                            \
+    }                                                                          \
+    void a_deque_##T##_reserve(a_deque_##T* d, size_t cap) {                   \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (cap <= d->cap)                                                     \
+            return;                                                            \
+        size_t new_cap = d->cap;                                               \
+        while (new_cap < cap)                                                  \
+            new_cap *= 2;                                                      \
+        /* unwrap the ring while moving it, so the elements start at 0. */     \
+        T* data = malloc(new_cap * sizeof(T));                                 \
+        check_alloc(data);                                                     \
+        size_t first = d->cap - d->head;                                       \
+        if (first > d->len)                                                    \
+            first = d->len;                                                    \
+        memcpy(data, &d->data[d->head], first * sizeof(T));                    \
+        memcpy(&data[first], d->data, (d->len - first) * sizeof(T));           \
+        free(d->data);                                                         \
+        d->data = data;                                                        \
+        d->head = 0;                                                           \
+        d->cap = new_cap;                                                      \
+    }                                                                          \
+    T* a_deque_##T##_at(a_deque_##T* d, size_t pos) {                          \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (pos >= d->len) {                                                   \
+            panic("deque index %zu out of range", pos);                        \
+        }                                                                      \
+        return &d->data[(d->head + pos) & (d->cap - 1)];                       \
+    }                                                                          \
+    void a_deque_##T##_push_back(a_deque_##T* d, T new_elem) {                 \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (d->len == d->cap) {                                                \
+            a_deque_##T##_reserve(d, d->cap * 2);                              \
+        }                                                                      \
+        d->data[(d->head + d->len++) & (d->cap - 1)] = new_elem;               \
+    }                                                                          \
+    void a_deque_##T##_push_front(a_deque_##T* d, T new_elem) {                \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (d->len == d->cap) {                                                \
+            a_deque_##T##_reserve(d, d->cap * 2);                              \
+        }                                                                      \
+        d->head = (d->head - 1) & (d->cap - 1);                                \
+        d->data[d->head] = new_elem;                                           \
+        d->len++;                                                              \
+    }                                                                          \
+    T a_deque_##T##_pop_back(a_deque_##T* d) {                                 \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (d->len == 0) {                                                     \
+            panic("cannot pop from an empty deque");                           \
+        }                                                                      \
+        return d->data[(d->head + --d->len) & (d->cap - 1)];                   \
+    }                                                                          \
+    T a_deque_##T##_pop_front(a_deque_##T* d) {                                \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (d->len == 0) {                                                     \
+            panic("cannot pop from an empty deque");                           \
+        }                                                                      \
+        T res = d->data[d->head];                                              \
+        d->head = (d->head + 1) & (d->cap - 1);                                \
+        d->len--;                                                              \
+        return res;                                                            \
+    }                                                                          \
+    void a_deque_##T##_push_back_slice(a_deque_##T* d, const T* ptr,           \
+                                       size_t nitems) {                        \
+        a_deque_##T##_seg first, second;                                       \
+        a_deque_##T##_spare(d, nitems, &first, &second);                       \
+        size_t n = (nitems < first.len) ? nitems : first.len;                  \
+        memcpy(first.data, ptr, n * sizeof(T));                                \
+        memcpy(second.data, &ptr[n], (nitems - n) * sizeof(T));                \
+        d->len += nitems;                                                      \
+    }                                                                          \
+    size_t a_deque_##T##_pop_front_slice(a_deque_##T* d, T* out,               \
+                                         size_t nitems) {                      \
+        a_deque_##T##_seg first, second;                                       \
+        a_deque_##T##_segments(d, &first, &second);                            \
+        if (nitems > d->len)                                                   \
+            nitems = d->len;                                                   \
+        size_t n = (nitems < first.len) ? nitems : first.len;                  \
+        memcpy(out, first.data, n * sizeof(T));                                \
+        memcpy(&out[n], second.data, (nitems - n) * sizeof(T));                \
+        d->head = (d->head + nitems) & (d->cap - 1);                           \
+        d->len -= nitems;                                                      \
+        return nitems;                                                         \
+    }                                                                          \
+    void a_deque_##T##_segments(const a_deque_##T* d,                          \
+                                a_deque_##T##_seg* first,                      \
+                                a_deque_##T##_seg* second) {                   \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        size_t n = d->cap - d->head;                                           \
+        if (n > d->len)                                                        \
+            n = d->len;                                                        \
+        *first = (a_deque_##T##_seg){.data = &d->data[d->head], .len = n};     \
+        *second = (a_deque_##T##_seg){.data = d->data, .len = d->len - n};     \
+    }                                                                          \
+    void a_deque_##T##_consume_front(a_deque_##T* d, size_t nitems) {          \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (nitems > d->len) {                                                 \
+            panic("cannot consume %zu of %zu elements", nitems, d->len);       \
+        }                                                                      \
+        for (size_t i = 0; i < nitems; i++)                                    \
+            drop_fn(&d->data[(d->head + i) & (d->cap - 1)]);                   \
+        d->head = (d->head + nitems) & (d->cap - 1);                           \
+        d->len -= nitems;                                                      \
+    }                                                                          \
+    void a_deque_##T##_spare(a_deque_##T* d, size_t nitems,                    \
+                             a_deque_##T##_seg* first,                         \
+                             a_deque_##T##_seg* second) {                      \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        a_deque_##T##_reserve(d, d->len + nitems);                             \
+        if (d->len == 0)                                                       \
+            d->head = 0; /* keep the spare room in one piece */                \
+        size_t tail = (d->head + d->len) & (d->cap - 1);                       \
+        size_t free_len = d->cap - d->len;                                     \
+        size_t n = d->cap - tail;                                              \
+        if (n > free_len)                                                      \
+            n = free_len;                                                      \
+        *first = (a_deque_##T##_seg){.data = &d->data[tail], .len = n};        \
+        *second = (a_deque_##T##_seg){.data = d->data, .len = free_len - n};   \
+    }                                                                          \
+    void a_deque_##T##_commit_back(a_deque_##T* d, size_t nitems) {            \
+        if (!a_deque_##T##_valid(d)) {                                         \
+            panic("the deque is invalid");                                     \
+        }                                                                      \
+        if (nitems > d->cap - d->len) {                                        \
+            panic("cannot commit %zu elements with %zu spare", nitems,         \
+                  d->cap - d->len);                                            \
+        }                                                                      \
+        d->len += nitems;                                                      \
+    }
+
+#endif // _A_DEQUE_H
@@ -0,0 +1,517 @@
+/*
+ * a_frame: flicker-free terminal drawing by diffing frames.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_frame.h"
+
+static const a_cell blank = {
+    .cp = ' ',
+    .fg = A_COLOR_DEFAULT,
+    .bg = A_COLOR_DEFAULT,
+    .attr = 0,
+};
+
+static inline bool style_eq(a_cell a, a_cell b) {
+    return a.fg == b.fg && a.bg == b.bg && a.attr == b.attr;
+}
+
+// compares fields, since the padding of a cell is not initialized.
+static inline bool cell_eq(a_cell a, a_cell b) {
+    return a.cp == b.cp && style_eq(a, b);
+}
+
+static size_t digits(size_t n) {
+    size_t res = 1;
+    while (n >= 10) {
+        n /= 10;
+        res++;
+    }
+    return res;
+}
+
+static inline void put(a_frame* f, const char* s, size_t len) {
+    a_string_append_view(&f->out, (a_string_view){.data = s, .len = len});
+}
+
+#define put_lit(f, s) put((f), (s), sizeof(s) - 1)
+
+// appends "\033[" n c, e.g. a relative cursor movement.
+static void put_csi(a_frame* f, size_t n, char c) {
+    put_lit(f, "\033[");
+    a_string_append_u64(&f->out, n);
+    put(f, &c, 1);
+}
+
+static void put_cup(a_frame* f, size_t x, size_t y) {
+    put_lit(f, "\033[");
+    a_string_append_u64(&f->out, y + 1);
+    put_lit(f, ";");
+    a_string_append_u64(&f->out, x + 1);
+    put_lit(f, "H");
+}
+
+// the codepoint that is actually shown for a cell.
+static inline u32 shown_cp(u32 cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0))
+        return ' '; // control characters would move the cursor
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000))
+        return 0xFFFD;
+    return cp;
+}
+
+static inline size_t utf8_len(u32 cp) {
+    return (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+}
+
+static void put_cp(a_frame* f, u32 cp) {
+    char buf[4];
+    cp = shown_cp(cp);
+    size_t n = utf8_len(cp);
+    switch (n) {
+    case 1:
+        buf[0] = (char)cp;
+        break;
+    case 2:
+        buf[0] = (char)(0xC0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3F));
+        break;
+    case 3:
+        buf[0] = (char)(0xE0 | (cp >> 12));
+        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (cp & 0x3F));
+        break;
+    default:
+        buf[0] = (char)(0xF0 | (cp >> 18));
+        buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[3] = (char)(0x80 | (cp & 0x3F));
+        break;
+    }
+    put(f, buf, n);
+}
+
+typedef struct {
+    char data[64];
+    size_t len;
+} sgr_buf;
+
+static void sgr_param(sgr_buf* b, size_t n) {
+    if (b->len > 0)
+        b->data[b->len++] = ';';
+    size_t end = b->len + digits(n);
+    for (size_t i = end; i > b->len; n /= 10)
+        b->data[--i] = (char)('0' + n % 10);
+    b->len = end;
+}
+
+// base is 30 for the foreground and 40 for the background.
+static void sgr_color(sgr_buf* b, u16 color, size_t base) {
+    if (color >= A_COLOR_DEFAULT) {
+        sgr_param(b, base + 9);
+    } else if (color < 8) {
+        sgr_param(b, base + color);
+    } else if (color < 16) {
+        sgr_param(b, base + 60 + color - 8);
+    } else {
+        sgr_param(b, base + 8);
+        sgr_param(b, 5);
+        sgr_param(b, color);
+    }
+}
+
+// the parameters that turn the style `from` into `to`.
+static void sgr_diff(sgr_buf* b, a_cell from, a_cell to) {
+    u16 removed = from.attr & ~to.attr;
+    u16 added = to.attr & ~from.attr;
+
+    // bold and dim are turned off together.
+    if (removed & (A_ATTR_BOLD | A_ATTR_DIM)) {
+        sgr_param(b, 22);
+        added |= to.attr & (A_ATTR_BOLD | A_ATTR_DIM);
+    }
+    if (removed & A_ATTR_ITALIC)
+        sgr_param(b, 23);
+    if (removed & A_ATTR_UNDERLINE)
+        sgr_param(b, 24);
+    if (removed & A_ATTR_REVERSE)
+        sgr_param(b, 27);
+
+    if (added & A_ATTR_BOLD)
+        sgr_param(b, 1);
+    if (added & A_ATTR_DIM)
+        sgr_param(b, 2);
+    if (added & A_ATTR_ITALIC)
+        sgr_param(b, 3);
+    if (added & A_ATTR_UNDERLINE)
+        sgr_param(b, 4);
+    if (added & A_ATTR_REVERSE)
+        sgr_param(b, 7);
+
+    if (to.fg != from.fg)
+        sgr_color(b, to.fg, 30);
+    if (to.bg != from.bg)
+        sgr_color(b, to.bg, 40);
+}
+
+// switches the pen to the style of c, with whichever of an incremental
+// change or a reset is shorter.
+static void set_pen(a_frame* f, a_cell c) {
+    if (f->pen_known && style_eq(f->pen, c))
+        return;
+
+    sgr_buf reset = {.len = 0};
+    sgr_param(&reset, 0);
+    sgr_diff(&reset, blank, c);
+
+    sgr_buf* best = &reset;
+    sgr_buf diff = {.len = 0};
+    if (f->pen_known) {
+        sgr_diff(&diff, f->pen, c);
+        if (diff.len <= reset.len)
+            best = &diff;
+    }
+
+    put_lit(f, "\033[");
+    put(f, best->data, best->len);
+    put_lit(f, "m");
+    f->pen = c;
+    f->pen_known = true;
+}
+
+/*
+ * the number of bytes needed to reach column x of row y by writing the cells
+ * in between again, or (size_t)-1 if they are not all in the current pen or
+ * take more than `limit` bytes.
+ */
+static size_t rewrite_cost(const a_frame* f, size_t x, size_t y,
+                           size_t limit) {
+    if (!f->pen_known)
+        return (size_t)-1;
+
+    const a_cell* row = &f->back[y * f->width];
+    size_t cost = 0;
+    for (size_t i = f->term_x; i < x; i++) {
+        if (!style_eq(row[i], f->pen))
+            return (size_t)-1;
+        cost += utf8_len(shown_cp(row[i].cp));
+        if (cost >= limit)
+            return (size_t)-1;
+    }
+    return cost;
+}
+
+enum {
+    MOVE_CUP,
+    MOVE_FORWARD,
+    MOVE_REWRITE,
+    MOVE_BACK,
+    MOVE_CR,
+    MOVE_CRLF,
+};
+
+// moves the cursor to (x, y) with the fewest bytes.
+static void move_to(a_frame* f, size_t x, size_t y) {
+    if (f->term_pos_known && f->term_x == x && f->term_y == y)
+        return;
+
+    int how = MOVE_CUP;
+    size_t best = 4 + digits(y + 1) + digits(x + 1);
+    size_t col = x ? 3 + digits(x) : 0; // from column 0
+
+    if (f->term_pos_known && f->term_y == y) {
+        if (x > f->term_x) {
+            size_t n = x - f->term_x;
+            size_t cost = 3 + digits(n);
+            if (cost < best) {
+                how = MOVE_FORWARD;
+                best = cost;
+            }
+            cost = rewrite_cost(f, x, y, best);
+            if (cost < best) {
+                how = MOVE_REWRITE;
+                best = cost;
+            }
+        } else {
+            size_t n = f->term_x - x;
+            size_t cost = (n == 1) ? 1 : 3 + digits(n);
+            if (cost < best) {
+                how = MOVE_BACK;
+                best = cost;
+            }
+        }
+        if (1 + col < best) {
+            how = MOVE_CR;
+            best = 1 + col;
+        }
+    } else if (f->term_pos_known && f->term_y + 1 == y) {
+        if (2 + col < best) {
+            how = MOVE_CRLF;
+            best = 2 + col;
+        }
+    }
+
+    switch (how) {
+    case MOVE_CUP:
+        put_cup(f, x, y);
+        break;
+    case MOVE_FORWARD:
+        put_csi(f, x - f->term_x, 'C');
+        break;
+    case MOVE_REWRITE:
+        for (size_t i = f->term_x; i < x; i++)
+            put_cp(f, f->back[y * f->width + i].cp);
+        break;
+    case MOVE_BACK:
+        if (f->term_x - x == 1)
+            put_lit(f, "\b");
+        else
+            put_csi(f, f->term_x - x, 'D');
+        break;
+    case MOVE_CR:
+    case MOVE_CRLF:
+        if (how == MOVE_CR)
+            put_lit(f, "\r");
+        else
+            put_lit(f, "\r\n");
+        if (x > 0)
+            put_csi(f, x, 'C');
+        break;
+    }
+
+    f->term_x = x;
+    f->term_y = y;
+    f->term_pos_known = true;
+}
+
+static a_frame frame_invalid(void) {
+    return (a_frame){
+        .fd = -1,
+        .width = (size_t)-1,
+        .height = (size_t)-1,
+        .front = NULL,
+        .back = NULL,
+        .out = a_string_new_invalid(),
+    };
+}
+
+static void fill_blank(a_cell* cells, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        cells[i] = blank;
+}
+
+// (re)allocates both buffers for the current size, filled with blanks.
+static void alloc_cells(a_frame* f) {
+    size_t n = f->width * f->height;
+    if (f->height != 0 && n / f->height != f->width)
+        panic("frame of %zux%zu cells is too large", f->width, f->height);
+
+    free(f->front);
+    free(f->back);
+    f->front = malloc((n ? n : 1) * sizeof(a_cell));
+    check_alloc(f->front);
+    f->back = malloc((n ? n : 1) * sizeof(a_cell));
+    check_alloc(f->back);
+    fill_blank(f->front, n);
+    fill_blank(f->back, n);
+}
+
+a_frame a_frame_new(int fd, size_t width, size_t height) {
+    a_frame res = {
+        .fd = fd,
+        .width = width,
+        .height = height,
+        .front = NULL,
+        .back = NULL,
+        .out = a_string_with_capacity(256),
+        .full_redraw = true,
+        .cursor_visible = true,
+    };
+    alloc_cells(&res);
+    return res;
+}
+
+void a_frame_free(a_frame* f) {
+    if (!a_frame_valid(f))
+        return;
+
+    free(f->front);
+    free(f->back);
+    a_string_free(&f->out);
+    *f = frame_invalid();
+}
+
+bool a_frame_valid(const a_frame* f) {
+    return !(f->width == (size_t)-1 || f->front == NULL || f->back == NULL);
+}
+
+void a_frame_resize(a_frame* f, size_t width, size_t height) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+
+    f->width = width;
+    f->height = height;
+    alloc_cells(f);
+    f->full_redraw = true;
+}
+
+void a_frame_invalidate(a_frame* f) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+
+    f->full_redraw = true;
+}
+
+void a_frame_clear(a_frame* f) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+
+    fill_blank(f->back, f->width * f->height);
+}
+
+void a_frame_set(a_frame* f, size_t x, size_t y, a_cell cell) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+
+    if (x < f->width && y < f->height)
+        f->back[y * f->width + x] = cell;
+}
+
+size_t a_frame_print(a_frame* f, size_t x, size_t y, a_string_view text,
+                     u16 fg, u16 bg, u16 attr) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+    if (y >= f->height)
+        return 0;
+
+    a_cell* row = &f->back[y * f->width];
+    a_string_utf8_iter it = a_string_utf8_iter_new(text.data, text.len);
+    size_t start = x;
+    u32 cp;
+    while (x < f->width && a_string_utf8_next(&it, &cp)) {
+        row[x++] = (a_cell){
+            .cp = cp,
+            .fg = fg,
+            .bg = bg,
+            .attr = attr,
+        };
+    }
+    return (x > start) ? x - start : 0;
+}
+
+void a_frame_set_cursor(a_frame* f, size_t x, size_t y, bool visible) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+
+    f->cursor_x = x;
+    f->cursor_y = y;
+    f->cursor_visible = visible;
+}
+
+static bool write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+bool a_frame_present(a_frame* f) {
+    if (!a_frame_valid(f))
+        panic("cannot operate on an invalid a_frame!");
+
+    size_t w = f->width;
+    size_t h = f->height;
+    bool changed = false;
+    f->out.len = 0;
+
+    if (f->full_redraw) {
+        // clearing is cheaper than writing every blank cell, and leaves
+        // nothing behind after a resize. The terminal's state is unknown.
+        put_lit(f, "\033[?25l\033[0m\033[2J");
+        fill_blank(f->front, w * h);
+        f->pen = blank;
+        f->pen_known = true;
+        f->term_pos_known = false;
+        f->term_cursor_shown = false;
+        f->full_redraw = false;
+        changed = true;
+    }
+
+    for (size_t y = 0; y < h; y++) {
+        const a_cell* back = &f->back[y * w];
+        a_cell* front = &f->front[y * w];
+        for (size_t x = 0; x < w; x++) {
+            if (cell_eq(back[x], front[x]))
+                continue;
+
+            if (f->term_cursor_shown) {
+                put_lit(f, "\033[?25l");
+                f->term_cursor_shown = false;
+            }
+            changed = true;
+            move_to(f, x, y);
+            set_pen(f, back[x]);
+            put_cp(f, back[x].cp);
+            front[x] = back[x];
+
+            // past the last column, the cursor position depends on the
+            // terminal.
+            if (x + 1 == w)
+                f->term_pos_known = false;
+            else
+                f->term_x = x + 1;
+        }
+    }
+
+    bool visible = f->cursor_visible && w > 0 && h > 0;
+    size_t cx = (f->cursor_x < w) ? f->cursor_x : w - 1;
+    size_t cy = (f->cursor_y < h) ? f->cursor_y : h - 1;
+    if (!changed) {
+        bool in_place = f->term_pos_known && f->term_x == cx &&
+                        f->term_y == cy;
+        if (visible == f->term_cursor_shown && (!visible || in_place))
+            return true; // nothing to send
+    }
+
+    // leave the terminal in the default style for anything else that
+    // writes to it.
+    if (!f->pen_known || !style_eq(f->pen, blank)) {
+        put_lit(f, "\033[0m");
+        f->pen = blank;
+        f->pen_known = true;
+    }
+    if (visible) {
+        move_to(f, cx, cy);
+        if (!f->term_cursor_shown)
+            put_lit(f, "\033[?25h");
+    } else if (f->term_cursor_shown) {
+        put_lit(f, "\033[?25l");
+    }
+    f->term_cursor_shown = visible;
+
+    if (!write_all(f->fd, f->out.data, f->out.len)) {
+        // the front buffer no longer matches the terminal.
+        int err = errno;
+        f->full_redraw = true;
+        errno = err;
+        return false;
+    }
+    return true;
+}
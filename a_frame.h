@@ -0,0 +1,161 @@
+/*
+ * a_frame: flicker-free terminal drawing by diffing frames.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_FRAME_H
+#define _A_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+// the terminal's default foreground or background color.
+#define A_COLOR_DEFAULT 256
+
+#define A_ATTR_BOLD      0x01
+#define A_ATTR_DIM       0x02
+#define A_ATTR_ITALIC    0x04
+#define A_ATTR_UNDERLINE 0x08
+#define A_ATTR_REVERSE   0x10
+
+/**
+ * one character cell of the screen.
+ */
+typedef struct {
+    // the codepoint shown. Every codepoint is assumed to be one column wide.
+    u32 cp;
+
+    // foreground color: 0-255 from the 256 color palette, or
+    // `A_COLOR_DEFAULT`.
+    u16 fg;
+
+    // background color, like fg.
+    u16 bg;
+
+    // a combination of the `A_ATTR_*` flags.
+    u16 attr;
+} a_cell;
+
+/**
+ * a double-buffered screen.
+ *
+ * a frame is drawn into the back buffer, and `a_frame_present` compares it
+ * with the front buffer, which holds what the terminal is showing. Only the
+ * cells that changed are sent, with the cheapest cursor movement and the
+ * fewest attribute changes, collected into one string and written with a
+ * single `write`. Nothing is shown half drawn, and unchanged parts of the
+ * screen cost nothing.
+ */
+typedef struct {
+    // the terminal's file descriptor. It is not owned by the frame.
+    int fd;
+
+    // size of the screen in cells.
+    size_t width;
+    size_t height;
+
+    // what the terminal shows.
+    a_cell* front;
+
+    // the frame being drawn.
+    a_cell* back;
+
+    // output of the frame being presented; kept to reuse its buffer.
+    a_string out;
+
+    // whether the next present has to redraw every cell.
+    bool full_redraw;
+
+    // where the cursor goes after a present, and whether it is shown.
+    size_t cursor_x;
+    size_t cursor_y;
+    bool cursor_visible;
+
+    // what the terminal is known to be in: the cursor position, the colors
+    // and attributes of the next character, and whether the cursor is shown.
+    size_t term_x;
+    size_t term_y;
+    bool term_pos_known;
+    a_cell pen;
+    bool pen_known;
+    bool term_cursor_shown;
+} a_frame;
+
+/**
+ * creates a frame of blank cells. The first present draws every cell.
+ *
+ * @param fd the terminal to write to
+ * @param width the number of columns
+ * @param height the number of rows
+ */
+a_frame a_frame_new(int fd, size_t width, size_t height);
+
+/**
+ * frees a frame. The terminal is left as it is.
+ */
+void a_frame_free(a_frame* f);
+
+/**
+ * checks if a frame is valid.
+ */
+bool a_frame_valid(const a_frame* f);
+
+/**
+ * changes the size of the screen. The back buffer is cleared and the next
+ * present redraws every cell.
+ */
+void a_frame_resize(a_frame* f, size_t width, size_t height);
+
+/**
+ * makes the next present redraw every cell, e.g. after something else wrote
+ * to the terminal.
+ */
+void a_frame_invalidate(a_frame* f);
+
+/**
+ * fills the back buffer with spaces in the default colors.
+ */
+void a_frame_clear(a_frame* f);
+
+/**
+ * sets a cell of the back buffer. Cells off the screen are ignored.
+ */
+void a_frame_set(a_frame* f, size_t x, size_t y, a_cell cell);
+
+/**
+ * writes UTF-8 text into the back buffer, one codepoint per cell, clipped at
+ * the right edge of the screen.
+ *
+ * @param x the first column
+ * @param y the row
+ * @param text the text
+ * @param fg the foreground color
+ * @param bg the background color
+ * @param attr the `A_ATTR_*` flags
+ * @return the number of cells written
+ */
+size_t a_frame_print(a_frame* f, size_t x, size_t y, a_string_view text,
+                     u16 fg, u16 bg, u16 attr);
+
+/**
+ * sets where the cursor is left after each present, and whether it is shown.
+ */
+void a_frame_set_cursor(a_frame* f, size_t x, size_t y, bool visible);
+
+/**
+ * sends the changes between the back and front buffers to the terminal in a
+ * single write, after which the front buffer matches the back buffer. The
+ * back buffer is kept, so the next frame can be drawn on top of it.
+ *
+ * @return false if writing failed, with errno set. The next present then
+ *         redraws every cell.
+ */
+bool a_frame_present(a_frame* f);
+
+#endif // _A_FRAME_H
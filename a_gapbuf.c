@@ -0,0 +1,187 @@
+/*
+ * a_gapbuf: a gap buffer for editing text at a cursor.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "a_common.h"
+#include "a_gapbuf.h"
+
+static inline size_t gap_len(const a_gapbuf* g) {
+    return g->gap_end - g->gap_start;
+}
+
+static inline void check_valid(const a_gapbuf* g) {
+    if (!a_gapbuf_valid(g))
+        panic("cannot operate on an invalid a_gapbuf!");
+}
+
+a_gapbuf a_gapbuf_new(void) { return a_gapbuf_with_capacity(64); }
+
+a_gapbuf a_gapbuf_with_capacity(size_t cap) {
+    a_gapbuf res = {.cap = cap ? cap : 1, .gap_start = 0};
+    res.gap_end = res.cap;
+    res.data = malloc(res.cap);
+    check_alloc(res.data);
+    return res;
+}
+
+a_gapbuf a_gapbuf_from_view(a_string_view text) {
+    if (text.data == NULL && text.len != 0)
+        panic("cannot copy a null view!");
+
+    // leave some room, since the text is about to be edited.
+    a_gapbuf res = a_gapbuf_with_capacity(text.len + text.len / 4 + 64);
+    a_gapbuf_insert(&res, text);
+    return res;
+}
+
+void a_gapbuf_free(a_gapbuf* g) {
+    if (!a_gapbuf_valid(g))
+        return;
+
+    free(g->data);
+    g->data = NULL;
+    g->cap = (size_t)-1;
+}
+
+bool a_gapbuf_valid(const a_gapbuf* g) {
+    return !(g->cap == (size_t)-1 || g->data == NULL);
+}
+
+size_t a_gapbuf_len(const a_gapbuf* g) {
+    check_valid(g);
+    return g->cap - gap_len(g);
+}
+
+size_t a_gapbuf_cursor(const a_gapbuf* g) {
+    check_valid(g);
+    return g->gap_start;
+}
+
+char a_gapbuf_get(const a_gapbuf* g, size_t pos) {
+    check_valid(g);
+    if (pos >= a_gapbuf_len(g))
+        panic("text offset %zu out of range", pos);
+
+    return pos < g->gap_start ? g->data[pos] : g->data[pos + gap_len(g)];
+}
+
+void a_gapbuf_move_to(a_gapbuf* g, size_t pos) {
+    check_valid(g);
+    if (pos > a_gapbuf_len(g))
+        panic("cursor position %zu out of range", pos);
+
+    if (pos < g->gap_start) {
+        // the bytes between pos and the cursor move to after the gap.
+        size_t n = g->gap_start - pos;
+        memmove(&g->data[g->gap_end - n], &g->data[pos], n);
+        g->gap_start -= n;
+        g->gap_end -= n;
+    } else if (pos > g->gap_start) {
+        size_t n = pos - g->gap_start;
+        memmove(&g->data[g->gap_start], &g->data[g->gap_end], n);
+        g->gap_start += n;
+        g->gap_end += n;
+    }
+}
+
+void a_gapbuf_move_left(a_gapbuf* g, size_t n) {
+    check_valid(g);
+    a_gapbuf_move_to(g, n < g->gap_start ? g->gap_start - n : 0);
+}
+
+void a_gapbuf_move_right(a_gapbuf* g, size_t n) {
+    size_t len = a_gapbuf_len(g);
+    size_t left = len - g->gap_start;
+    a_gapbuf_move_to(g, g->gap_start + (n < left ? n : left));
+}
+
+void a_gapbuf_reserve(a_gapbuf* g, size_t cap) {
+    check_valid(g);
+    if (cap <= g->cap)
+        return;
+
+    // the text after the gap moves to the end of the new buffer.
+    size_t tail = g->cap - g->gap_end;
+    g->data = realloc(g->data, cap);
+    check_alloc(g->data);
+    memmove(&g->data[cap - tail], &g->data[g->gap_end], tail);
+    g->gap_end = cap - tail;
+    g->cap = cap;
+}
+
+void a_gapbuf_insert(a_gapbuf* g, a_string_view text) {
+    check_valid(g);
+    if (text.data == NULL && text.len != 0)
+        panic("cannot insert a null view!");
+
+    if (text.len > gap_len(g)) {
+        size_t need = a_gapbuf_len(g) + text.len;
+        size_t cap = g->cap;
+        while (cap < need)
+            cap *= 2;
+        a_gapbuf_reserve(g, cap);
+    }
+    memcpy(&g->data[g->gap_start], text.data, text.len);
+    g->gap_start += text.len;
+}
+
+void a_gapbuf_insert_char(a_gapbuf* g, char c) {
+    check_valid(g);
+    if (g->gap_start == g->gap_end)
+        a_gapbuf_reserve(g, g->cap * 2);
+    g->data[g->gap_start++] = c;
+}
+
+size_t a_gapbuf_delete_back(a_gapbuf* g, size_t n) {
+    check_valid(g);
+    if (n > g->gap_start)
+        n = g->gap_start;
+    g->gap_start -= n;
+    return n;
+}
+
+size_t a_gapbuf_delete_forward(a_gapbuf* g, size_t n) {
+    check_valid(g);
+    size_t left = g->cap - g->gap_end;
+    if (n > left)
+        n = left;
+    g->gap_end += n;
+    return n;
+}
+
+void a_gapbuf_segments(const a_gapbuf* g, a_string_view* before,
+                       a_string_view* after) {
+    check_valid(g);
+    *before = (a_string_view){.data = g->data, .len = g->gap_start};
+    *after = (a_string_view){
+        .data = &g->data[g->gap_end],
+        .len = g->cap - g->gap_end,
+    };
+}
+
+a_string_view a_gapbuf_as_view(a_gapbuf* g) {
+    a_gapbuf_move_to(g, a_gapbuf_len(g));
+    return (a_string_view){.data = g->data, .len = g->gap_start};
+}
+
+a_string a_gapbuf_to_astr(const a_gapbuf* g) {
+    a_string_view before, after;
+    a_gapbuf_segments(g, &before, &after);
+
+    a_string res = a_string_with_capacity(before.len + after.len + 1);
+    check_alloc(res.data);
+    memcpy(res.data, before.data, before.len);
+    memcpy(&res.data[before.len], after.data, after.len);
+    res.len = before.len + after.len;
+    res.data[res.len] = '\0';
+    return res;
+}
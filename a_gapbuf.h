@@ -0,0 +1,163 @@
+/*
+ * a_gapbuf: a gap buffer for editing text at a cursor.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_GAPBUF_H
+#define _A_GAPBUF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+/**
+ * text buffer with a movable gap at the cursor.
+ *
+ * the text before the cursor sits at the start of the buffer and the text
+ * after it at the end, with the free space in between. Inserting or deleting
+ * at the cursor only moves the edges of the gap, and moving the cursor moves
+ * just the bytes it passes over, so typing is O(1) however big the text is.
+ */
+typedef struct {
+    // the buffer: text, gap, text.
+    char* data;
+
+    // size of the buffer.
+    size_t cap;
+
+    // start of the gap, which is also the cursor position.
+    size_t gap_start;
+
+    // end of the gap; the text after the cursor starts here.
+    size_t gap_end;
+} a_gapbuf;
+
+/**
+ * creates an empty gap buffer.
+ */
+a_gapbuf a_gapbuf_new(void);
+
+/**
+ * creates an empty gap buffer with room for a number of bytes.
+ *
+ * @param cap the number of bytes
+ */
+a_gapbuf a_gapbuf_with_capacity(size_t cap);
+
+/**
+ * creates a gap buffer holding a copy of some text, with the cursor at the
+ * end.
+ *
+ * @param text the text
+ */
+a_gapbuf a_gapbuf_from_view(a_string_view text);
+
+/**
+ * frees a gap buffer.
+ */
+void a_gapbuf_free(a_gapbuf* g);
+
+/**
+ * checks if a gap buffer is valid.
+ */
+bool a_gapbuf_valid(const a_gapbuf* g);
+
+/**
+ * gets the length of the text.
+ */
+size_t a_gapbuf_len(const a_gapbuf* g);
+
+/**
+ * gets the cursor position, as a byte offset into the text.
+ */
+size_t a_gapbuf_cursor(const a_gapbuf* g);
+
+/**
+ * gets the byte at an offset of the text.
+ *
+ * @param pos the offset
+ */
+char a_gapbuf_get(const a_gapbuf* g, size_t pos);
+
+/**
+ * moves the cursor to an offset. Costs the distance moved.
+ *
+ * @param pos the new cursor position, at most the length of the text
+ */
+void a_gapbuf_move_to(a_gapbuf* g, size_t pos);
+
+/**
+ * moves the cursor towards the start, stopping at it.
+ *
+ * @param n the number of bytes to move by
+ */
+void a_gapbuf_move_left(a_gapbuf* g, size_t n);
+
+/**
+ * moves the cursor towards the end, stopping at it.
+ *
+ * @param n the number of bytes to move by
+ */
+void a_gapbuf_move_right(a_gapbuf* g, size_t n);
+
+/**
+ * makes room for at least a number of bytes of text without reallocating.
+ *
+ * @param cap the number of bytes
+ */
+void a_gapbuf_reserve(a_gapbuf* g, size_t cap);
+
+/**
+ * inserts text at the cursor, and moves the cursor past it.
+ */
+void a_gapbuf_insert(a_gapbuf* g, a_string_view text);
+
+/**
+ * inserts a byte at the cursor, and moves the cursor past it.
+ */
+void a_gapbuf_insert_char(a_gapbuf* g, char c);
+
+/**
+ * deletes bytes before the cursor, like backspace.
+ *
+ * @param n the number of bytes. Deletes up to the start of the text.
+ * @return the number of bytes deleted
+ */
+size_t a_gapbuf_delete_back(a_gapbuf* g, size_t n);
+
+/**
+ * deletes bytes after the cursor, like the delete key.
+ *
+ * @param n the number of bytes. Deletes up to the end of the text.
+ * @return the number of bytes deleted
+ */
+size_t a_gapbuf_delete_forward(a_gapbuf* g, size_t n);
+
+/**
+ * gets the text as 2 views, before and after the cursor, without moving
+ * anything. The views are invalidated by the next edit.
+ *
+ * @param before where to store the text before the cursor
+ * @param after where to store the text after the cursor
+ */
+void a_gapbuf_segments(const a_gapbuf* g, a_string_view* before,
+                       a_string_view* after);
+
+/**
+ * gets the text as a single view by moving the gap, and with it the cursor,
+ * to the end. The view is invalidated by the next edit. Use
+ * `a_gapbuf_segments` to get at the text without moving the cursor.
+ */
+a_string_view a_gapbuf_as_view(a_gapbuf* g);
+
+/**
+ * copies the text into a new a_string.
+ */
+a_string a_gapbuf_to_astr(const a_gapbuf* g);
+
+#endif // _A_GAPBUF_H
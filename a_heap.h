@@ -0,0 +1,356 @@
+/*
+ * a_heap: priority queues on top of vectors.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_HEAP_H
+#define _A_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "a_vector.h"
+
+// default number of children per node.
+#define A_HEAP_ARITY 4
+
+// handle of an a_iheap that holds no element.
+#define A_HEAP_NONE ((size_t)-1)
+
+/*
+ * a d-ary min-heap over an `a_vector_T`, ordered by `less` like
+ * `A_SORTED_IMPL`: the element that goes before every other one is on top.
+ * The vector must already be declared and implemented with
+ * `A_VECTOR_DECL`/`A_VECTOR_IMPL`, and frees its elements as usual.
+ *
+ *     #define TASK_LESS(a, b) ((a).deadline < (b).deadline)
+ *     A_HEAP_DECL(task);                // in a header
+ *     A_HEAP_IMPL(task, TASK_LESS)      // in one .c file
+ *
+ * with 4 children per node, the tree is half as deep as a binary heap and
+ * the children compared at each level usually share a cache line, so pops
+ * touch fewer lines. `A_HEAP_IMPL_ARITY` picks another number of children.
+ *
+ * `a_iheap_T` also gives every element a handle when it is pushed, which
+ * stays valid until the element leaves the heap. Through it, an element
+ * can be looked up, removed, or moved with `decrease_key`/`update`, e.g. to
+ * reschedule a task, in O(log n).
+ */
+#define A_HEAP_DECL(T)                                                         \
+    typedef struct {                                                           \
+        a_vector_##T items;                                                    \
+    } a_heap_##T;                                                              \
+    typedef struct {                                                           \
+        a_vector_##T items;                                                    \
+        size_t* ids;                                                           \
+        size_t* pos;                                                           \
+        size_t* free_ids;                                                      \
+        size_t nfree;                                                          \
+        size_t nids;                                                           \
+        size_t ids_cap;                                                        \
+    } a_iheap_##T;                                                             \
+    a_heap_##T a_heap_##T##_new(void);                                         \
+    a_heap_##T a_heap_##T##_from_slice(const T* slice, size_t nitems);         \
+    a_heap_##T a_heap_##T##_from_vector(a_vector_##T* v);                      \
+    void a_heap_##T##_free(a_heap_##T* h);                                     \
+    bool a_heap_##T##_valid(const a_heap_##T* h);                              \
+    void a_heap_##T##_push(a_heap_##T* h, T elem);                             \
+    void a_heap_##T##_push_slice(a_heap_##T* h, const T* ptr, size_t nitems);  \
+    const T* a_heap_##T##_peek(const a_heap_##T* h);                           \
+    T a_heap_##T##_pop(a_heap_##T* h);                                         \
+    a_iheap_##T a_iheap_##T##_new(void);                                       \
+    void a_iheap_##T##_free(a_iheap_##T* h);                                   \
+    bool a_iheap_##T##_valid(const a_iheap_##T* h);                            \
+    size_t a_iheap_##T##_push(a_iheap_##T* h, T elem);                         \
+    const T* a_iheap_##T##_peek(const a_iheap_##T* h, size_t* id);             \
+    T a_iheap_##T##_pop(a_iheap_##T* h, size_t* id);                           \
+    bool a_iheap_##T##_contains(const a_iheap_##T* h, size_t id);              \
+    const T* a_iheap_##T##_get(const a_iheap_##T* h, size_t id);               \
+    void a_iheap_##T##_decrease_key(a_iheap_##T* h, size_t id, T elem);        \
+    void a_iheap_##T##_update(a_iheap_##T* h, size_t id, T elem);              \
+    T a_iheap_##T##_remove(a_iheap_##T* h, size_t id)
+
+#define A_HEAP_IMPL(T, less) A_HEAP_IMPL_ARITY(T, less, A_HEAP_ARITY)
+#define A_HEAP_IMPL_ARITY(T, less, D)                                          \
+    _Static_assert((D) >= 2, "a heap needs at least 2 children per node");     \
+    static void a_heap_##T##_sift_up(T* data, size_t i) {                      \
+        T elem = data[i];                                                      \
+        while (i > 0) {                                                        \
+            size_t parent = (i - 1) / (D);                                     \
+            if (!less(elem, data[parent]))                                     \
+                break;                                                         \
+            data[i] = data[parent];                                            \
+            i = parent;                                                        \
+        }                                                                      \
+        data[i] = elem;                                                        \
+    }                                                                          \
+    static void a_heap_##T##_sift_down(T* data, size_t len, size_t i) {        \
+        T elem = data[i];                                                      \
+        for (;;) {                                                             \
+            size_t first = i * (D) + 1;                                        \
+            if (first >= len)                                                  \
+                break;                                                         \
+            size_t end = (len - first > (D)) ? first + (D) : len;              \
+            size_t best = first;                                               \
+            for (size_t c = first + 1; c < end; c++)                           \
+                best = less(data[c], data[best]) ? c : best;                   \
+            if (!less(data[best], elem))                                       \
+                break;                                                         \
+            data[i] = data[best];                                              \
+            i = best;                                                          \
+        }                                                                      \
+        data[i] = elem;                                                        \
+    }                                                                          \
+    static void a_heap_##T##_heapify(T* data, size_t len) {                    \
+        if (len < 2)                                                           \
+            return;                                                            \
+        for (size_t i = (len - 2) / (D) + 1; i-- > 0;)                         \
+            a_heap_##T##_sift_down(data, len, i);                              \
+    }                                                                          \
+    a_heap_##T a_heap_##T##_new(void) {                                        \
+        return (a_heap_##T){.items = a_vector_##T##_new()};                    \
+    }                                                                          \
+    a_heap_##T a_heap_##T##_from_slice(const T* slice, size_t nitems) {        \
+        a_heap_##T res = a_heap_##T##_new();                                   \
+        a_heap_##T##_push_slice(&res, slice, nitems);                          \
+        return res;                                                            \
+    }                                                                          \
+    a_heap_##T a_heap_##T##_from_vector(a_vector_##T* v) {                     \
+        if (!a_vector_##T##_valid(v)) {                                        \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        a_heap_##T res = {.items = a_vector_##T##_take(v)};                    \
+        if (res.items.cap == 0)                                                \
+            a_vector_##T##_reserve(&res.items, 1); /* so that it can grow */   \
+        a_heap_##T##_heapify(res.items.data, res.items.len);                   \
+        return res;                                                            \
+    }                                                                          \
+    void a_heap_##T##_free(a_heap_##T* h) {                                    \
+        a_vector_##T##_free(&h->items);                                        \
+    }                                                                          \
+    bool a_heap_##T##_valid(const a_heap_##T* h) {                             \
+        return a_vector_##T##_valid((a_vector_##T*)&h->items);                 \
+    }                                                                          \
+    void a_heap_##T##_push(a_heap_##T* h, T elem) {                            \
+        if (!a_heap_##T##_valid(h)) {                                          \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        a_vector_##T##_append(&h->items, elem);                                \
+        a_heap_##T##_sift_up(h->items.data, h->items.len - 1);                 \
+    }                                                                          \
+    void a_heap_##T##_push_slice(a_heap_##T* h, const T* ptr,                  \
+                                 size_t nitems) {                              \
+        if (!a_heap_##T##_valid(h)) {                                          \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        if (nitems == 0)                                                       \
+            return;                                                            \
+        size_t old_len = h->items.len;                                         \
+        a_vector_##T##_append_slice(&h->items, ptr, nitems);                   \
+        /* rebuilding is O(n), sifting every new element up O(k log n). */     \
+        if (nitems > old_len) {                                                \
+            a_heap_##T##_heapify(h->items.data, h->items.len);                 \
+        } else {                                                               \
+            for (size_t i = old_len; i < h->items.len; i++)                    \
+                a_heap_##T##_sift_up(h->items.data, i);                        \
+        }                                                                      \
+    }                                                                          \
+    const T* a_heap_##T##_peek(const a_heap_##T* h) {                          \
+        if (!a_heap_##T##_valid(h)) {                                          \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        return (h->items.len > 0) ? &h->items.data[0] : NULL;                  \
+    }                                                                          \
+    T a_heap_##T##_pop(a_heap_##T* h) {                                        \
+        if (!a_heap_##T##_valid(h)) {                                          \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        if (h->items.len == 0) {                                               \
+            panic("cannot pop from an empty heap");                            \
+        }                                                                      \
+        T* data = h->items.data;                                               \
+        T res = data[0];                                                       \
+        size_t len = --h->items.len;                                           \
+        if (len > 0) {                                                         \
+            data[0] = data[len];                                               \
+            a_heap_##T##_sift_down(data, len, 0);                              \
+        }                                                                      \
+        return res;                                                            \
+    }                                                                          \
+    static inline void a_iheap_##T##_place(a_iheap_##T* h, size_t i, T elem,   \
+                                           size_t id) {                        \
+        h->items.data[i] = elem;                                               \
+        h->ids[i] = id;                                                        \
+        h->pos[id] = i;                                                        \
+    }                                                                          \
+    static void a_iheap_##T##_sift_up(a_iheap_##T* h, size_t i) {              \
+        T* data = h->items.data;                                               \
+        T elem = data[i];                                                      \
+        size_t id = h->ids[i];                                                 \
+        while (i > 0) {                                                        \
+            size_t parent = (i - 1) / (D);                                     \
+            if (!less(elem, data[parent]))                                     \
+                break;                                                         \
+            a_iheap_##T##_place(h, i, data[parent], h->ids[parent]);           \
+            i = parent;                                                        \
+        }                                                                      \
+        a_iheap_##T##_place(h, i, elem, id);                                   \
+    }                                                                          \
+    static void a_iheap_##T##_sift_down(a_iheap_##T* h, size_t i) {            \
+        T* data = h->items.data;                                               \
+        size_t len = h->items.len;                                             \
+        T elem = data[i];                                                      \
+        size_t id = h->ids[i];                                                 \
+        for (;;) {                                                             \
+            size_t first = i * (D) + 1;                                        \
+            if (first >= len)                                                  \
+                break;                                                         \
+            size_t end = (len - first > (D)) ? first + (D) : len;              \
+            size_t best = first;                                               \
+            for (size_t c = first + 1; c < end; c++)                           \
+                best = less(data[c], data[best]) ? c : best;                   \
+            if (!less(data[best], elem))                                       \
+                break;                                                         \
+            a_iheap_##T##_place(h, i, data[best], h->ids[best]);               \
+            i = best;                                                          \
+        }                                                                      \
+        a_iheap_##T##_place(h, i, elem, id);                                   \
+    }                                                                          \
+    /* takes the element at i out of the heap and frees its handle. */         \
+    static T a_iheap_##T##_take_at(a_iheap_##T* h, size_t i) {                 \
+        T res = h->items.data[i];                                              \
+        size_t id = h->ids[i];                                                 \
+        h->pos[id] = A_HEAP_NONE;                                              \
+        h->free_ids[h->nfree++] = id;                                          \
+        size_t last = --h->items.len;                                          \
+        if (i < last) {                                                        \
+            T moved = h->items.data[last];                                     \
+            a_iheap_##T##_place(h, i, moved, h->ids[last]);                    \
+            if (i > 0 && less(moved, h->items.data[(i - 1) / (D)]))            \
+                a_iheap_##T##_sift_up(h, i);                                   \
+            else                                                               \
+                a_iheap_##T##_sift_down(h, i);                                 \
+        }                                                                      \
+        return res;                                                            \
+    }                                                                          \
+    static size_t a_iheap_##T##_check_id(const a_iheap_##T* h, size_t id) {    \
+        if (!a_iheap_##T##_valid(h)) {                                         \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        if (!a_iheap_##T##_contains(h, id)) {                                  \
+            panic("heap handle %zu is not in the heap", id);                   \
+        }                                                                      \
+        return h->pos[id];                                                     \
+    }                                                                          \
+    a_iheap_##T a_iheap_##T##_new(void) {                                      \
+        a_iheap_##T res = {                                                    \
+            .items = a_vector_##T##_new(),                                     \
+            .nfree = 0,                                                        \
+            .nids = 0,                                                         \
+            .ids_cap = 8,                                                      \
+        };                                                                     \
+        res.ids = malloc(res.ids_cap * sizeof(size_t));                        \
+        check_alloc(res.ids);                                                  \
+        res.pos = malloc(res.ids_cap * sizeof(size_t));                        \
+        check_alloc(res.pos);                                                  \
+        res.free_ids = malloc(res.ids_cap * sizeof(size_t));                   \
+        check_alloc(res.free_ids);                                             \
+        return res;                                                            \
+    }                                                                          \
+    void a_iheap_##T##_free(a_iheap_##T* h) {                                  \
+        a_vector_##T##_free(&h->items);                                        \
+        free(h->ids);                                                          \
+        free(h->pos);                                                          \
+        free(h->free_ids);                                                     \
+        h->ids = NULL;                                                         \
+        h->pos = NULL;                                                         \
+        h->free_ids = NULL;                                                    \
+        h->nfree = 0;                                                          \
+        h->nids = 0;                                                           \
+        h->ids_cap = 0;                                                        \
+    }                                                                          \
+    bool a_iheap_##T##_valid(const a_iheap_##T* h) {                           \
+        return a_vector_##T##_valid((a_vector_##T*)&h->items) &&               \
+               h->pos != NULL;                                                 \
+    }                                                                          \
+    size_t a_iheap_##T##_push(a_iheap_##T* h, T elem) {                        \
+        if (!a_iheap_##T##_valid(h)) {                                         \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        size_t id;                                                             \
+        if (h->nfree > 0) {                                                    \
+            id = h->free_ids[--h->nfree];                                      \
+        } else {                                                               \
+            if (h->nids == h->ids_cap) {                                       \
+                h->ids_cap *= 2;                                               \
+                h->ids = realloc(h->ids, h->ids_cap * sizeof(size_t));         \
+                check_alloc(h->ids);                                           \
+                h->pos = realloc(h->pos, h->ids_cap * sizeof(size_t));         \
+                check_alloc(h->pos);                                           \
+                h->free_ids =                                                  \
+                    realloc(h->free_ids, h->ids_cap * sizeof(size_t));         \
+                check_alloc(h->free_ids);                                      \
+            }                                                                  \
+            id = h->nids++;                                                    \
+        }                                                                      \
+        a_vector_##T##_append(&h->items, elem);                                \
+        h->ids[h->items.len - 1] = id;                                         \
+        a_iheap_##T##_sift_up(h, h->items.len - 1);                            \
+        return id;                                                             \
+    }                                                                          \
+    const T* a_iheap_##T##_peek(const a_iheap_##T* h, size_t* id) {            \
+        if (!a_iheap_##T##_valid(h)) {                                         \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        if (h->items.len == 0) {                                               \
+            if (id)                                                            \
+                *id = A_HEAP_NONE;                                             \
+            return NULL;                                                       \
+        }                                                                      \
+        if (id)                                                                \
+            *id = h->ids[0];                                                   \
+        return &h->items.data[0];                                              \
+    }                                                                          \
+    T a_iheap_##T##_pop(a_iheap_##T* h, size_t* id) {                          \
+        if (!a_iheap_##T##_valid(h)) {                                         \
+            panic("the heap is invalid");                                      \
+        }                                                                      \
+        if (h->items.len == 0) {                                               \
+            panic("cannot pop from an empty heap");                            \
+        }                                                                      \
+        if (id)                                                                \
+            *id = h->ids[0];                                                   \
+        return a_iheap_##T##_take_at(h, 0);                                    \
+    }                                                                          \
+    bool a_iheap_##T##_contains(const a_iheap_##T* h, size_t id) {             \
+        return id < h->nids && h->pos[id] != A_HEAP_NONE;                      \
+    }                                                                          \
+    const T* a_iheap_##T##_get(const a_iheap_##T* h, size_t id) {              \
+        return &h->items.data[a_iheap_##T##_check_id(h, id)];                  \
+    }                                                                          \
+    void a_iheap_##T##_decrease_key(a_iheap_##T* h, size_t id, T elem) {       \
+        size_t i = a_iheap_##T##_check_id(h, id);                              \
+        if (less(h->items.data[i], elem)) {                                    \
+            panic("decrease_key would move heap handle %zu down", id);         \
+        }                                                                      \
+        h->items.data[i] = elem;                                               \
+        a_iheap_##T##_sift_up(h, i);                                           \
+    }                                                                          \
+    void a_iheap_##T##_update(a_iheap_##T* h, size_t id, T elem) {             \
+        size_t i = a_iheap_##T##_check_id(h, id);                              \
+        bool up = less(elem, h->items.data[i]);                                \
+        h->items.data[i] = elem;                                               \
+        if (up)                                                                \
+            a_iheap_##T##_sift_up(h, i);                                       \
+        else                                                                   \
+            a_iheap_##T##_sift_down(h, i);                                     \
+    }                                                                          \
+    T a_iheap_##T##_remove(a_iheap_##T* h, size_t id) {                        \
+        return a_iheap_##T##_take_at(h, a_iheap_##T##_check_id(h, id));        \
+    }
+
+#endif // _A_HEAP_H
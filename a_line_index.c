@@ -0,0 +1,334 @@
+/*
+ * a_line_index: random access to the lines of large text buffers.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_line_index.h"
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+// below this many bytes per thread, threads cost more than they save.
+#define MIN_CHUNK (1 << 20)
+
+// upper bound on the number of threads used to build an index.
+#define MAX_THREADS 64
+
+// bitmask of the `\n` bytes in the 64 bytes at p.
+static inline u64 newline_mask(const char* p) {
+#if defined(__x86_64__)
+    const __m128i nl = _mm_set1_epi8('\n');
+    u64 m0 = (u32)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), nl));
+    u64 m1 = (u32)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), nl));
+    u64 m2 = (u32)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), nl));
+    u64 m3 = (u32)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 48)), nl));
+    return m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+#else
+    u64 mask = 0;
+    for (int i = 0; i < 8; i++) {
+        u64 v;
+        memcpy(&v, p + i * 8, sizeof(v));
+        v ^= 0x0A0A0A0A0A0A0A0AULL; // `\n` bytes become zero
+        u64 t = ~(((v & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | v |
+                  0x7F7F7F7F7F7F7F7FULL);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        t = __builtin_bswap64(t);
+#endif
+        // gather the high bit of every byte into the low 8 bits.
+        mask |= (((t >> 7) * 0x0102040810204080ULL) >> 56) << (i * 8);
+    }
+    return mask;
+#endif
+}
+
+size_t a_line_index_count_newlines(const char* data, size_t len) {
+    size_t count = 0;
+    size_t i = 0;
+
+#if defined(__x86_64__)
+    // byte-wise counters, widened with psadbw before they can overflow.
+    const __m128i nl = _mm_set1_epi8('\n');
+    while (i + 16 <= len) {
+        __m128i acc = _mm_setzero_si128();
+        size_t rounds = (len - i) / 16;
+        if (rounds > 255)
+            rounds = 255;
+        for (size_t r = 0; r < rounds; r++, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)&data[i]);
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, nl));
+        }
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si64(sums) +
+                 (size_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+    }
+#else
+    for (; i + 64 <= len; i += 64)
+        count += (size_t)__builtin_popcountll(newline_mask(&data[i]));
+#endif
+
+    for (; i < len; i++)
+        count += (data[i] == '\n');
+    return count;
+}
+
+/*
+ * records the start of every stride-th line in data[begin, end). `seen` is
+ * the number of newlines before `begin`.
+ */
+static void record_samples(const char* data, size_t begin, size_t end,
+                           size_t seen, size_t stride, size_t* samples,
+                           size_t nsamples) {
+    size_t next = (seen / stride + 1) * stride;
+    size_t i = begin;
+
+    for (; i + 64 <= end; i += 64) {
+        u64 mask = newline_mask(&data[i]);
+        size_t n = (size_t)__builtin_popcountll(mask);
+        if (seen + n < next) {
+            seen += n;
+            continue;
+        }
+        while (mask) {
+            size_t bit = (size_t)__builtin_ctzll(mask);
+            mask &= mask - 1;
+            if (++seen == next) {
+                if (seen / stride < nsamples)
+                    samples[seen / stride] = i + bit + 1;
+                next += stride;
+            }
+        }
+    }
+
+    for (; i < end; i++) {
+        if (data[i] == '\n' && ++seen == next) {
+            if (seen / stride < nsamples)
+                samples[seen / stride] = i + 1;
+            next += stride;
+        }
+    }
+}
+
+static a_line_index line_index_invalid(void) {
+    return (a_line_index){
+        .data = NULL,
+        .len = (size_t)-1,
+        .samples = NULL,
+    };
+}
+
+// allocates the index once the number of newlines is known.
+static a_line_index line_index_alloc(const char* data, size_t len,
+                                     size_t stride, size_t newlines) {
+    a_line_index res = {
+        .data = data,
+        .len = len,
+        .stride = stride,
+        .map_len = 0,
+    };
+    res.nlines = newlines;
+    if (len > 0 && data[len - 1] != '\n')
+        res.nlines++; // last line has no newline
+
+    res.nsamples = (res.nlines + stride - 1) / stride;
+    res.samples = malloc((res.nsamples ? res.nsamples : 1) * sizeof(size_t));
+    check_alloc(res.samples);
+    if (res.nsamples > 0)
+        res.samples[0] = 0;
+    return res;
+}
+
+a_line_index a_line_index_new(const char* data, size_t len, size_t stride) {
+    if (data == NULL && len != 0)
+        panic("cannot index a null buffer!");
+    if (stride == 0)
+        stride = 1;
+
+    size_t newlines = a_line_index_count_newlines(data, len);
+    a_line_index res = line_index_alloc(data, len, stride, newlines);
+    record_samples(data, 0, len, 0, stride, res.samples, res.nsamples);
+    return res;
+}
+
+typedef struct {
+    const char* data;
+    size_t begin;
+    size_t end;
+    size_t seen; // newlines before begin, filled in between the 2 passes
+    size_t count;
+    size_t stride;
+    size_t* samples;
+    size_t nsamples;
+} index_chunk;
+
+static void* count_chunk(void* arg) {
+    index_chunk* c = arg;
+    c->count = a_line_index_count_newlines(&c->data[c->begin],
+                                           c->end - c->begin);
+    return NULL;
+}
+
+static void* sample_chunk(void* arg) {
+    index_chunk* c = arg;
+    record_samples(c->data, c->begin, c->end, c->seen, c->stride, c->samples,
+                   c->nsamples);
+    return NULL;
+}
+
+// runs fn over every chunk, the first one on the calling thread.
+static void run_chunks(index_chunk* chunks, size_t n, void* (*fn)(void*)) {
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS] = {false};
+
+    for (size_t i = 1; i < n; i++) {
+        started[i] = pthread_create(&threads[i], NULL, fn, &chunks[i]) == 0;
+        if (!started[i])
+            fn(&chunks[i]);
+    }
+    fn(&chunks[0]);
+    for (size_t i = 1; i < n; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+    }
+}
+
+a_line_index a_line_index_new_parallel(const char* data, size_t len,
+                                       size_t stride, size_t nthreads) {
+    if (data == NULL && len != 0)
+        panic("cannot index a null buffer!");
+    if (stride == 0)
+        stride = 1;
+
+    if (nthreads == 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (ncpu > 0) ? (size_t)ncpu : 1;
+    }
+    if (nthreads > MAX_THREADS)
+        nthreads = MAX_THREADS;
+    if (nthreads > len / MIN_CHUNK)
+        nthreads = len / MIN_CHUNK;
+    if (nthreads <= 1)
+        return a_line_index_new(data, len, stride);
+
+    // newline counting works on any byte boundary, so chunks are split
+    // evenly. The first pass counts newlines per chunk, the second one
+    // records samples once each chunk knows how many lines precede it.
+    index_chunk chunks[MAX_THREADS];
+    size_t chunk_len = len / nthreads;
+    for (size_t i = 0; i < nthreads; i++) {
+        chunks[i] = (index_chunk){
+            .data = data,
+            .begin = i * chunk_len,
+            .end = (i + 1 == nthreads) ? len : (i + 1) * chunk_len,
+            .stride = stride,
+        };
+    }
+    run_chunks(chunks, nthreads, count_chunk);
+
+    size_t newlines = 0;
+    for (size_t i = 0; i < nthreads; i++) {
+        chunks[i].seen = newlines;
+        newlines += chunks[i].count;
+    }
+
+    a_line_index res = line_index_alloc(data, len, stride, newlines);
+    for (size_t i = 0; i < nthreads; i++) {
+        chunks[i].samples = res.samples;
+        chunks[i].nsamples = res.nsamples;
+    }
+    run_chunks(chunks, nthreads, sample_chunk);
+    return res;
+}
+
+a_line_index a_line_index_from_astr(const a_string* s, size_t stride) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    return a_line_index_new_parallel(s->data, s->len, stride, 0);
+}
+
+a_line_index a_line_index_open(const char* filename, size_t stride) {
+    if (filename == NULL)
+        panic("source file name C string is null!");
+
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return line_index_invalid();
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return line_index_invalid();
+    }
+
+    size_t len = (size_t)st.st_size;
+    const char* data = "";
+    if (len > 0) {
+        void* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            int err = errno;
+            close(fd);
+            errno = err;
+            return line_index_invalid();
+        }
+        data = map;
+    }
+    close(fd);
+
+    a_line_index res = a_line_index_new_parallel(data, len, stride, 0);
+    res.map_len = len;
+    return res;
+}
+
+void a_line_index_free(a_line_index* idx) {
+    if (!a_line_index_valid(idx))
+        return;
+
+    if (idx->map_len > 0)
+        munmap((void*)idx->data, idx->map_len);
+    free(idx->samples);
+    *idx = line_index_invalid();
+}
+
+bool a_line_index_valid(const a_line_index* idx) {
+    return !(idx->len == (size_t)-1 || idx->samples == NULL);
+}
+
+a_string_view a_line_index_get(const a_line_index* idx, size_t line) {
+    if (!a_line_index_valid(idx))
+        panic("cannot operate on an invalid a_line_index!");
+    if (line >= idx->nlines)
+        panic("line %zu out of range", line);
+
+    const char* end = idx->data + idx->len;
+    const char* p = idx->data + idx->samples[line / idx->stride];
+    for (size_t skip = line % idx->stride; skip > 0; skip--)
+        p = (const char*)memchr(p, '\n', (size_t)(end - p)) + 1;
+
+    const char* nl = memchr(p, '\n', (size_t)(end - p));
+    return (a_string_view){
+        .data = p,
+        .len = (size_t)((nl ? nl : end) - p),
+    };
+}
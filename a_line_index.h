@@ -0,0 +1,123 @@
+/*
+ * a_line_index: random access to the lines of large text buffers.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_LINE_INDEX_H
+#define _A_LINE_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+/**
+ * index of line start offsets into a text buffer.
+ *
+ * lines are separated by `\n`, and a trailing `\n` does not start another
+ * line. Only the start of every `stride`th line is stored, so a lookup skips
+ * at most `stride - 1` lines with memchr; a stride of 1 makes lookups O(1)
+ * at the cost of one offset per line.
+ */
+typedef struct {
+    // the indexed bytes. Owned by the index only if it was made with
+    // `a_line_index_open`.
+    const char* data;
+
+    // length of the indexed bytes.
+    size_t len;
+
+    // number of lines.
+    size_t nlines;
+
+    // distance (in lines) between two stored offsets.
+    size_t stride;
+
+    // offset of line i * stride, for every i < nsamples.
+    size_t* samples;
+
+    // number of stored offsets.
+    size_t nsamples;
+
+    // size of the file mapping, or 0 if the index does not own `data`.
+    size_t map_len;
+} a_line_index;
+
+/**
+ * builds a line index over a buffer, which must outlive the index.
+ *
+ * @param data the bytes to index
+ * @param len the number of bytes
+ * @param stride keep the offset of every stride-th line. 0 means 1.
+ */
+a_line_index a_line_index_new(const char* data, size_t len, size_t stride);
+
+/**
+ * builds a line index over a buffer with several threads, each scanning a
+ * chunk of the buffer. The result is the same as `a_line_index_new`.
+ *
+ * @param data the bytes to index
+ * @param len the number of bytes
+ * @param stride keep the offset of every stride-th line. 0 means 1.
+ * @param nthreads number of threads to use. 0 uses one per online CPU.
+ */
+a_line_index a_line_index_new_parallel(const char* data, size_t len,
+                                       size_t stride, size_t nthreads);
+
+/**
+ * builds a line index over an a_string, which must outlive the index and
+ * must not be modified while it is in use.
+ *
+ * @param s the string to index
+ * @param stride keep the offset of every stride-th line. 0 means 1.
+ */
+a_line_index a_line_index_from_astr(const a_string* s, size_t stride);
+
+/**
+ * maps a file into memory read-only and builds a line index over it, in
+ * parallel. The mapping is released by `a_line_index_free`.
+ *
+ * Returns an invalid index upon error, and sets errno.
+ *
+ * @param filename the name of the file
+ * @param stride keep the offset of every stride-th line. 0 means 1.
+ */
+a_line_index a_line_index_open(const char* filename, size_t stride);
+
+/**
+ * frees an index, and unmaps its file if it was made by `a_line_index_open`.
+ *
+ * @param idx the index
+ */
+void a_line_index_free(a_line_index* idx);
+
+/**
+ * checks if an index is valid.
+ *
+ * @param idx the index
+ */
+bool a_line_index_valid(const a_line_index* idx);
+
+/**
+ * gets a line by number, without its `\n`.
+ *
+ * @param idx the index
+ * @param line the 0-based line number, which must be less than `nlines`
+ * @return a view into the indexed buffer
+ */
+a_string_view a_line_index_get(const a_line_index* idx, size_t line);
+
+/**
+ * counts the `\n` bytes in a buffer, 16 bytes at a time where SSE2 is
+ * available.
+ *
+ * @param data the bytes
+ * @param len the number of bytes
+ */
+size_t a_line_index_count_newlines(const char* data, size_t len);
+
+#endif // _A_LINE_INDEX_H
@@ -0,0 +1,189 @@
+/*
+ * a_lines: parallel line-by-line processing of large text buffers.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_lines.h"
+
+// upper bound on the number of worker threads.
+#define MAX_THREADS 64
+
+// chunks per thread, so that a thread that finishes early can pick up work.
+#define CHUNKS_PER_THREAD 8
+
+// smallest chunk worth handing to a thread.
+#define MIN_CHUNK (256 * 1024)
+
+typedef struct {
+    const char* data;
+    size_t len;
+    size_t chunk_len;
+    size_t nchunks;
+    _Atomic(size_t) next;
+    const a_lines_worker* w;
+} lines_job;
+
+typedef struct {
+    lines_job* job;
+    void* state;
+} lines_thread;
+
+// first byte at or after pos that starts a line.
+static size_t line_boundary(const char* data, size_t len, size_t pos) {
+    if (pos == 0)
+        return 0;
+    if (pos >= len)
+        return len;
+    if (data[pos - 1] == '\n')
+        return pos;
+
+    const char* nl = memchr(&data[pos], '\n', len - pos);
+    return nl ? (size_t)(nl - data) + 1 : len;
+}
+
+static void run_lines(const lines_job* job, size_t begin, size_t end,
+                      void* state) {
+    const char* p = &job->data[begin];
+    const char* stop = &job->data[end];
+    while (p < stop) {
+        const char* nl = memchr(p, '\n', (size_t)(stop - p));
+        const char* line_end = nl ? nl : stop;
+        job->w->line(state, (a_string_view){p, (size_t)(line_end - p)},
+                     job->w->ctx);
+        p = line_end + 1;
+    }
+}
+
+static void* lines_thread_main(void* arg) {
+    lines_thread* t = arg;
+    lines_job* job = t->job;
+
+    for (;;) {
+        size_t c = atomic_fetch_add_explicit(&job->next, 1,
+                                             memory_order_relaxed);
+        if (c >= job->nchunks)
+            break;
+
+        // both ends are moved to line starts the same way, so neighbouring
+        // chunks always meet.
+        size_t begin = line_boundary(job->data, job->len, c * job->chunk_len);
+        size_t end = (c + 1 == job->nchunks)
+                         ? job->len
+                         : line_boundary(job->data, job->len,
+                                         (c + 1) * job->chunk_len);
+        if (begin < end)
+            run_lines(job, begin, end, t->state);
+    }
+    return NULL;
+}
+
+void a_lines_parallel(const char* data, size_t len, size_t nthreads,
+                      const a_lines_worker* w) {
+    if (w == NULL || w->line == NULL)
+        panic("a line callback is required!");
+    if (data == NULL && len != 0)
+        panic("cannot process a null buffer!");
+
+    if (nthreads == 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (ncpu > 0) ? (size_t)ncpu : 1;
+    }
+    if (nthreads > MAX_THREADS)
+        nthreads = MAX_THREADS;
+
+    size_t nchunks = nthreads * CHUNKS_PER_THREAD;
+    if (nchunks > len / MIN_CHUNK)
+        nchunks = len / MIN_CHUNK;
+    if (nchunks == 0)
+        nchunks = 1;
+    if (nthreads > nchunks)
+        nthreads = nchunks;
+
+    lines_job job = {
+        .data = data,
+        .len = len,
+        .chunk_len = len / nchunks,
+        .nchunks = nchunks,
+        .w = w,
+    };
+    atomic_init(&job.next, 0);
+
+    lines_thread threads[MAX_THREADS];
+    pthread_t handles[MAX_THREADS];
+    bool started[MAX_THREADS] = {false};
+    for (size_t i = 0; i < nthreads; i++) {
+        threads[i].job = &job;
+        threads[i].state = w->init ? w->init(w->ctx) : NULL;
+    }
+
+    // the calling thread acts as worker 0. if a thread cannot be started,
+    // the remaining workers simply take over its chunks.
+    for (size_t i = 1; i < nthreads; i++)
+        started[i] = pthread_create(&handles[i], NULL, lines_thread_main,
+                                    &threads[i]) == 0;
+    lines_thread_main(&threads[0]);
+    for (size_t i = 1; i < nthreads; i++) {
+        if (started[i])
+            pthread_join(handles[i], NULL);
+    }
+
+    for (size_t i = 0; i < nthreads; i++) {
+        if (w->merge)
+            w->merge(threads[i].state, w->ctx);
+    }
+}
+
+bool a_lines_parallel_file(const char* filename, size_t nthreads,
+                           const a_lines_worker* w) {
+    if (filename == NULL)
+        panic("source file name C string is null!");
+
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+
+    size_t len = (size_t)st.st_size;
+    if (len == 0) {
+        close(fd);
+        a_lines_parallel("", 0, nthreads, w);
+        return true;
+    }
+
+    void* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED) {
+        errno = err;
+        return false;
+    }
+
+    // chunks are read front to back, so let the kernel read ahead.
+    madvise(map, len, MADV_SEQUENTIAL);
+    a_lines_parallel(map, len, nthreads, w);
+    munmap(map, len);
+    return true;
+}
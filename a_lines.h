@@ -0,0 +1,68 @@
+/*
+ * a_lines: parallel line-by-line processing of large text buffers.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_LINES_H
+#define _A_LINES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+/**
+ * callbacks for `a_lines_parallel`.
+ *
+ * every worker thread gets its own state from `init`, so `line` never has to
+ * synchronize. Once all lines are processed, `merge` is called for each
+ * worker's state, one at a time, on the calling thread.
+ */
+typedef struct {
+    // creates the state of one worker. may be NULL, in which case the state
+    // is NULL.
+    void* (*init)(void* ctx);
+
+    // processes one line, given without its `\n`. Lines of one worker are
+    // seen in order within a chunk, but chunks are handed out dynamically.
+    void (*line)(void* state, a_string_view line, void* ctx);
+
+    // folds the state of one worker into the result, and frees it. may be
+    // NULL.
+    void (*merge)(void* state, void* ctx);
+
+    // passed to every callback.
+    void* ctx;
+} a_lines_worker;
+
+/**
+ * runs a callback over every line of a buffer on several threads.
+ *
+ * the buffer is cut into chunks whose boundaries are moved forward to the
+ * next `\n`, so no line is ever split, and idle workers pick up the next
+ * unclaimed chunk. Line semantics match `a_line_index`.
+ *
+ * @param data the bytes
+ * @param len the number of bytes
+ * @param nthreads number of threads to use. 0 uses one per online CPU.
+ * @param w the callbacks
+ */
+void a_lines_parallel(const char* data, size_t len, size_t nthreads,
+                      const a_lines_worker* w);
+
+/**
+ * maps a file into memory read-only and runs `a_lines_parallel` over it.
+ *
+ * @param filename the name of the file
+ * @param nthreads number of threads to use. 0 uses one per online CPU.
+ * @param w the callbacks
+ * @return false if the file could not be opened or mapped, with errno set
+ */
+bool a_lines_parallel_file(const char* filename, size_t nthreads,
+                           const a_lines_worker* w);
+
+#endif // _A_LINES_H
@@ -0,0 +1,403 @@
+/*
+ * a_log: asynchronous logging behind the macros of a_common.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_log.h"
+#include "a_writer.h"
+
+// size of the thread-local buffer records are formatted into. Longer
+// records are allocated.
+#define RECORD_MAX 1024
+
+// size of a queue slot. Records that do not fit are allocated.
+#define SLOT_SIZE 256
+
+/*
+ * a slot of the queue, after Dmitry Vyukov's bounded MPMC queue: `seq` is
+ * the position the slot is free for, plus 1 once a record is in it.
+ */
+typedef struct {
+    _Alignas(64) _Atomic(size_t) seq;
+    size_t len;
+    char* big;
+    char data[SLOT_SIZE - 2 * sizeof(size_t) - sizeof(char*)];
+} log_slot;
+
+static struct {
+    a_log_config cfg;
+
+    log_slot* slots;
+    size_t mask;
+
+    // next position to claim, shared by every logging thread.
+    _Alignas(64) _Atomic(size_t) tail;
+
+    // next position to write, private to the writer thread.
+    _Alignas(64) size_t head;
+
+    // every record before this position is written.
+    _Atomic(size_t) written;
+
+    _Atomic(bool) running;
+
+    // threads between seeing the logger running and publishing a record.
+    _Atomic(int) producers;
+    _Atomic(bool) stopping;
+    _Atomic(int) sleeping;
+    _Atomic(int) waiters;
+    bool atexit_registered;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t drained;
+    pthread_t thread;
+} logger = {
+    .cfg =
+        {
+            .fd = STDERR_FILENO,
+            .timestamps = false,
+            .queue_len = A_LOG_DEFAULT_QUEUE_LEN,
+        },
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .drained = PTHREAD_COND_INITIALIZER,
+};
+
+static _Thread_local char record_buf[RECORD_MAX];
+
+// the formatted second of the last timestamp of this thread.
+static _Thread_local struct {
+    time_t sec;
+    char text[32];
+    size_t len;
+} last_time = {.sec = -1};
+
+static const char* const tags[] = {
+    [A_LOG_DEBUG] = S_BOLD "[debug] " S_END S_DIM,
+    [A_LOG_INFO] = S_CYAN S_BOLD "[info] " S_END S_DIM,
+    [A_LOG_WARN] = S_MAGENTA S_BOLD "[warn] " S_END S_DIM,
+    [A_LOG_FATAL] = S_RED S_BOLD "[fatal] " S_END S_DIM,
+};
+
+static const char suffix[] = S_END "\n";
+
+static void write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return; // there is nowhere to report it
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+// writes the timestamp and tag of a record to buf, which has room for both.
+static size_t format_prefix(char* buf, int level) {
+    size_t len = 0;
+
+    if (logger.cfg.timestamps) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        if (ts.tv_sec != last_time.sec) {
+            struct tm tm;
+            localtime_r(&ts.tv_sec, &tm);
+            last_time.len = strftime(last_time.text, sizeof(last_time.text),
+                                     S_DIM "%Y-%m-%d %H:%M:%S", &tm);
+            last_time.sec = ts.tv_sec;
+        }
+        memcpy(buf, last_time.text, last_time.len);
+        len += last_time.len;
+
+        int ms = (int)(ts.tv_nsec / 1000000);
+        buf[len++] = '.';
+        buf[len++] = (char)('0' + ms / 100);
+        buf[len++] = (char)('0' + ms / 10 % 10);
+        buf[len++] = (char)('0' + ms % 10);
+        memcpy(&buf[len], S_END " ", sizeof(S_END " ") - 1);
+        len += sizeof(S_END " ") - 1;
+    }
+
+    size_t tag_len = strlen(tags[level]);
+    memcpy(&buf[len], tags[level], tag_len);
+    return len + tag_len;
+}
+
+static void wake_writer(void) {
+    pthread_mutex_lock(&logger.lock);
+    pthread_cond_signal(&logger.wake);
+    pthread_mutex_unlock(&logger.lock);
+}
+
+// pushes a record onto the queue. `big` is the allocated copy of a record
+// that does not fit in a slot, or NULL.
+static void enqueue(const char* data, size_t len, char* big) {
+    if (big == NULL && len > sizeof(((log_slot*)0)->data)) {
+        big = malloc(len);
+        check_alloc(big);
+        memcpy(big, data, len);
+    }
+
+    log_slot* slot;
+    size_t pos = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+    for (;;) {
+        slot = &logger.slots[pos & logger.mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(
+                    &logger.tail, &pos, pos + 1, memory_order_relaxed,
+                    memory_order_relaxed))
+                break;
+        } else if ((ptrdiff_t)(seq - pos) < 0) {
+            // the queue is full: let the writer catch up, unless the logger
+            // is stopping and nothing may drain it any more.
+            if (!atomic_load_explicit(&logger.running, memory_order_seq_cst)) {
+                write_all(logger.cfg.fd, big ? big : data, len);
+                free(big);
+                return;
+            }
+            wake_writer();
+            sched_yield();
+            pos = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+        }
+    }
+
+    slot->len = len;
+    slot->big = big;
+    if (big == NULL)
+        memcpy(slot->data, data, len);
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    // pairs with the fence in writer_sleep: either the writer sees the
+    // record, or this thread sees that it sleeps.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&logger.sleeping, memory_order_relaxed))
+        wake_writer();
+}
+
+static bool slot_ready(size_t pos) {
+    log_slot* slot = &logger.slots[pos & logger.mask];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1;
+}
+
+// copies every published record to w, freeing their slots.
+static size_t drain(a_writer* w) {
+    size_t n = 0;
+    while (slot_ready(logger.head)) {
+        log_slot* slot = &logger.slots[logger.head & logger.mask];
+        if (slot->big) {
+            a_writer_write(w, slot->big, slot->len);
+            free(slot->big);
+        } else {
+            a_writer_write(w, slot->data, slot->len);
+        }
+        atomic_store_explicit(&slot->seq, logger.head + logger.mask + 1,
+                              memory_order_release);
+        logger.head++;
+        n++;
+    }
+    return n;
+}
+
+static void writer_sleep(void) {
+    pthread_mutex_lock(&logger.lock);
+    atomic_store_explicit(&logger.sleeping, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!slot_ready(logger.head) &&
+        !atomic_load_explicit(&logger.stopping, memory_order_relaxed))
+        pthread_cond_wait(&logger.wake, &logger.lock);
+    atomic_store_explicit(&logger.sleeping, 0, memory_order_relaxed);
+    pthread_mutex_unlock(&logger.lock);
+}
+
+static void* writer_main(void* arg) {
+    (void)arg;
+    a_writer w = a_writer_new(logger.cfg.fd);
+
+    for (;;) {
+        // everything published while the last batch was written goes out
+        // in the next one.
+        if (drain(&w) > 0) {
+            a_writer_flush(&w);
+            atomic_store_explicit(&logger.written, logger.head,
+                                  memory_order_seq_cst);
+            if (atomic_load_explicit(&logger.waiters, memory_order_seq_cst)) {
+                pthread_mutex_lock(&logger.lock);
+                pthread_cond_broadcast(&logger.drained);
+                pthread_mutex_unlock(&logger.lock);
+            }
+            continue;
+        }
+        if (atomic_load_explicit(&logger.stopping, memory_order_acquire))
+            break;
+        writer_sleep();
+    }
+
+    a_writer_free(&w);
+    return NULL;
+}
+
+a_log_config a_log_default_config(void) {
+    return (a_log_config){
+        .fd = STDERR_FILENO,
+        .timestamps = false,
+        .queue_len = A_LOG_DEFAULT_QUEUE_LEN,
+    };
+}
+
+void a_log_configure(const a_log_config* cfg) {
+    if (atomic_load_explicit(&logger.running, memory_order_relaxed))
+        panic("cannot configure the logger while it is started!");
+
+    logger.cfg = cfg ? *cfg : a_log_default_config();
+}
+
+bool a_log_start(const a_log_config* cfg) {
+    if (atomic_load_explicit(&logger.running, memory_order_relaxed))
+        return true;
+    if (cfg)
+        a_log_configure(cfg);
+
+    size_t len = 2;
+    while (len < logger.cfg.queue_len)
+        len *= 2;
+
+    // the slots of a stopped logger are reused when the size matches.
+    if (logger.slots == NULL || logger.mask + 1 != len) {
+        free(logger.slots);
+        logger.slots = aligned_alloc(64, len * sizeof(log_slot));
+        check_alloc(logger.slots);
+        logger.mask = len - 1;
+    }
+    for (size_t i = 0; i < len; i++)
+        atomic_init(&logger.slots[i].seq, i);
+    atomic_store(&logger.tail, 0);
+    logger.head = 0;
+    atomic_store(&logger.written, 0);
+    atomic_store(&logger.stopping, false);
+
+    int err = pthread_create(&logger.thread, NULL, writer_main, NULL);
+    if (err != 0) {
+        errno = err;
+        return false;
+    }
+    atomic_store_explicit(&logger.running, true, memory_order_release);
+
+    if (!logger.atexit_registered) {
+        atexit(a_log_stop);
+        logger.atexit_registered = true;
+    }
+    return true;
+}
+
+void a_log_stop(void) {
+    if (!atomic_load_explicit(&logger.running, memory_order_relaxed))
+        return;
+
+    // new records are written synchronously from here on. Records of
+    // threads that saw the logger running are waited for, while the writer
+    // thread still drains the queue.
+    atomic_store_explicit(&logger.running, false, memory_order_seq_cst);
+    while (atomic_load_explicit(&logger.producers, memory_order_seq_cst) > 0)
+        sched_yield();
+
+    atomic_store_explicit(&logger.stopping, true, memory_order_release);
+    wake_writer();
+    pthread_join(logger.thread, NULL);
+
+    // nothing should be left, but a record is never dropped.
+    a_writer w = a_writer_new(logger.cfg.fd);
+    drain(&w);
+    a_writer_free(&w);
+    atomic_store_explicit(&logger.written, logger.head, memory_order_seq_cst);
+}
+
+void a_log_flush(void) {
+    if (!atomic_load_explicit(&logger.running, memory_order_acquire))
+        return;
+    // e.g. a panic in the writer thread: nothing else would drain the queue.
+    if (pthread_equal(pthread_self(), logger.thread))
+        return;
+
+    size_t target = atomic_load_explicit(&logger.tail, memory_order_relaxed);
+    atomic_fetch_add_explicit(&logger.waiters, 1, memory_order_seq_cst);
+    pthread_mutex_lock(&logger.lock);
+    while (atomic_load_explicit(&logger.written, memory_order_seq_cst) <
+           target) {
+        pthread_cond_signal(&logger.wake);
+        pthread_cond_wait(&logger.drained, &logger.lock);
+    }
+    pthread_mutex_unlock(&logger.lock);
+    atomic_fetch_sub_explicit(&logger.waiters, 1, memory_order_relaxed);
+}
+
+void a_log_vwrite(int level, const char* fmt, va_list args) {
+    if (level < A_LOG_DEBUG || level > A_LOG_FATAL)
+        panic("invalid log level %d", level);
+
+    size_t prefix = format_prefix(record_buf, level);
+    size_t room = RECORD_MAX - prefix - sizeof(suffix);
+
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(&record_buf[prefix], room + 1, fmt, args);
+    if (n < 0)
+        n = 0;
+
+    char* rec = record_buf;
+    char* big = NULL;
+    if ((size_t)n > room) {
+        big = malloc(prefix + (size_t)n + sizeof(suffix));
+        check_alloc(big);
+        memcpy(big, record_buf, prefix);
+        vsnprintf(&big[prefix], (size_t)n + 1, fmt, copy);
+        rec = big;
+    }
+    va_end(copy);
+
+    size_t len = prefix + (size_t)n;
+    memcpy(&rec[len], suffix, sizeof(suffix) - 1);
+    len += sizeof(suffix) - 1;
+
+    // pairs with a_log_stop: either it sees this thread as a producer and
+    // waits for the record, or this thread sees it stopped.
+    atomic_fetch_add_explicit(&logger.producers, 1, memory_order_seq_cst);
+    if (atomic_load_explicit(&logger.running, memory_order_seq_cst)) {
+        enqueue(rec, len, big);
+        atomic_fetch_sub_explicit(&logger.producers, 1, memory_order_release);
+        if (level >= A_LOG_FATAL)
+            a_log_flush();
+    } else {
+        atomic_fetch_sub_explicit(&logger.producers, 1, memory_order_release);
+        write_all(logger.cfg.fd, rec, len);
+        free(big);
+    }
+}
+
+void a_log_write(int level, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    a_log_vwrite(level, fmt, args);
+    va_end(args);
+}
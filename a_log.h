@@ -0,0 +1,131 @@
+/*
+ * a_log: asynchronous logging behind the macros of a_common.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_LOG_H
+#define _A_LOG_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+
+#define A_LOG_DEBUG 0
+#define A_LOG_INFO  1
+#define A_LOG_WARN  2
+#define A_LOG_FATAL 3
+#define A_LOG_OFF   4
+
+/*
+ * records below this level are removed at compile time. Define it before
+ * including any asv header, e.g. with `-DA_LOG_LEVEL=A_LOG_WARN`.
+ */
+#ifndef A_LOG_LEVEL
+#define A_LOG_LEVEL A_LOG_INFO
+#endif
+
+// default number of records the queue holds.
+#define A_LOG_DEFAULT_QUEUE_LEN 1024
+
+#define a_log(level, ...)                                                      \
+    {                                                                          \
+        if ((level) >= A_LOG_LEVEL)                                            \
+            a_log_write((level), __VA_ARGS__);                                 \
+    }
+
+#define a_log_debug(...) a_log(A_LOG_DEBUG, __VA_ARGS__)
+
+/**
+ * settings of the logger.
+ */
+typedef struct {
+    // where records are written. It is not owned by the logger.
+    int fd;
+
+    // whether records start with the local time, to the millisecond, at
+    // which they were logged.
+    bool timestamps;
+
+    // number of records the queue holds, rounded up to a power of 2. When
+    // it is full, logging threads wait for the writer thread.
+    size_t queue_len;
+} a_log_config;
+
+/**
+ * the default settings: stderr, no timestamps and
+ * `A_LOG_DEFAULT_QUEUE_LEN` records.
+ */
+a_log_config a_log_default_config(void);
+
+/**
+ * sets where and how records are written, without starting the writer
+ * thread. Until `a_log_start` is called, every record is written by the
+ * thread that logs it, with a single `write`.
+ *
+ * must not be called while the logger is started.
+ *
+ * @param cfg the settings, or NULL for the defaults
+ */
+void a_log_configure(const a_log_config* cfg);
+
+/**
+ * starts the background writer thread. From then on, records are formatted
+ * by the logging thread into a thread-local buffer, pushed onto a lock-free
+ * queue and written in batches by the writer thread, so logging does not
+ * wait for the file descriptor. `a_log_stop` is registered with `atexit`.
+ *
+ * @param cfg the settings, or NULL to keep the current ones
+ * @return false if the thread could not be started, with errno set. Records
+ *         are then still written synchronously.
+ */
+bool a_log_start(const a_log_config* cfg);
+
+/**
+ * writes every queued record and stops the writer thread. Records logged by
+ * other threads while it stops are still written, either through the queue
+ * or synchronously.
+ */
+void a_log_stop(void);
+
+/**
+ * waits until every record logged before the call is written. Records of
+ * level `A_LOG_FATAL` are flushed automatically, and `panic` flushes before
+ * it prints. Does nothing on the writer thread, which would wait on itself.
+ *
+ * declared weak so that `panic` in header-only code, like the a_vector
+ * macros, still links without a_log.o.
+ */
+void a_log_flush(void) __attribute__((weak));
+
+/**
+ * calls `a_log_flush` if a_log.o is linked in. Used by `panic`.
+ */
+static inline void a_log_panic_flush(void) {
+    // read through a volatile pointer, since the compiler assumes the
+    // address of a function it sees defined is never null.
+    void (*volatile flush)(void) = a_log_flush;
+    if (flush)
+        flush();
+}
+
+/**
+ * logs a record. Prefer the `a_log` macro, which removes records below
+ * `A_LOG_LEVEL` at compile time.
+ *
+ * @param level one of the `A_LOG_*` levels
+ * @param fmt a printf format string
+ */
+void a_log_write(int level, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * like `a_log_write`, with a va_list.
+ */
+void a_log_vwrite(int level, const char* fmt, va_list args);
+
+#endif // _A_LOG_H
@@ -0,0 +1,267 @@
+/*
+ * a_matcher: multi-pattern string search (Aho-Corasick).
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a_common.h"
+#include "a_matcher.h"
+
+// marks a missing trie edge while the automaton is built.
+#define NO_EDGE UINT32_MAX
+
+static inline u8 fold_byte(u8 b, bool ignore_case) {
+    return (ignore_case && b >= 'A' && b <= 'Z') ? (u8)(b | 0x20) : b;
+}
+
+static a_matcher matcher_invalid(void) {
+    return (a_matcher){.next = NULL, .nodes = NULL, .nstates = (size_t)-1};
+}
+
+// gives every byte used by a pattern its own class. Returns the class count.
+static size_t build_classes(u8* classes, const a_string_view* patterns,
+                            size_t n, bool ignore_case) {
+    bool used[256] = {false};
+    for (size_t i = 0; i < n; i++) {
+        const u8* p = (const u8*)patterns[i].data;
+        for (size_t j = 0; j < patterns[i].len; j++)
+            used[fold_byte(p[j], ignore_case)] = true;
+    }
+
+    size_t nused = 0;
+    for (size_t b = 0; b < 256; b++)
+        nused += used[b];
+
+    // class 0 is shared by every byte that no pattern uses, if there are any.
+    size_t ncls = (nused == 256) ? 0 : 1;
+    memset(classes, 0, 256);
+    for (size_t b = 0; b < 256; b++) {
+        if (used[b] && fold_byte((u8)b, ignore_case) == b)
+            classes[b] = (u8)ncls++;
+    }
+    for (size_t b = 0; b < 256; b++) {
+        u8 f = fold_byte((u8)b, ignore_case);
+        if (f != b && used[f])
+            classes[b] = classes[f];
+    }
+    return ncls;
+}
+
+a_matcher a_matcher_new(const a_string_view* patterns, size_t n,
+                        bool ignore_case) {
+    if (patterns == NULL && n != 0)
+        panic("cannot compile a null pattern array!");
+
+    a_matcher res = {.npatterns = n};
+    size_t ncls = build_classes(res.classes, patterns, n, ignore_case);
+    u32 shift = 0;
+    while (((size_t)1 << shift) < ncls)
+        shift++;
+    res.class_shift = shift;
+    size_t width = (size_t)1 << shift;
+
+    // the trie can have at most one state per pattern byte, plus the root.
+    size_t max_states = 1;
+    for (size_t i = 0; i < n; i++) {
+        if (patterns[i].len == 0)
+            panic("pattern %zu is empty!", i);
+        max_states += patterns[i].len;
+    }
+    if (max_states > (UINT32_MAX >> shift))
+        panic("too many pattern bytes: %zu", max_states);
+
+    u32* next = malloc(max_states * width * sizeof(u32));
+    check_alloc(next);
+    a_matcher_node* nodes = calloc(max_states, sizeof(a_matcher_node));
+    check_alloc(nodes);
+    for (size_t i = 0; i < width; i++)
+        next[i] = NO_EDGE;
+
+    size_t nstates = 1;
+    for (size_t i = 0; i < n; i++) {
+        const u8* p = (const u8*)patterns[i].data;
+        u32 s = 0;
+        for (size_t j = 0; j < patterns[i].len; j++) {
+            u32* edge = &next[(size_t)s * width + res.classes[p[j]]];
+            if (*edge == NO_EDGE) {
+                u32 t = (u32)nstates++;
+                for (size_t c = 0; c < width; c++)
+                    next[(size_t)t * width + c] = NO_EDGE;
+                nodes[t].depth = (u32)(j + 1);
+                *edge = t;
+            }
+            s = *edge;
+        }
+        if (nodes[s].pattern == 0)
+            nodes[s].pattern = (u32)(i + 1);
+    }
+
+    /*
+     * turns the trie into a DFA, breadth first, so that the failure state of
+     * every state is complete before the state itself. A missing edge takes
+     * the edge of the failure state.
+     */
+    u32* fail = calloc(nstates, sizeof(u32));
+    check_alloc(fail);
+    u32* queue = malloc(nstates * sizeof(u32));
+    check_alloc(queue);
+    size_t head = 0, tail = 0;
+
+    for (size_t c = 0; c < width; c++) {
+        u32 t = next[c];
+        if (t == NO_EDGE) {
+            next[c] = 0;
+        } else {
+            fail[t] = 0;
+            nodes[t].longest = nodes[t].pattern ? t : 0;
+            queue[tail++] = t;
+        }
+    }
+    while (head < tail) {
+        u32 s = queue[head++];
+        u32* row = &next[(size_t)s * width];
+        const u32* fail_row = &next[(size_t)fail[s] * width];
+        for (size_t c = 0; c < width; c++) {
+            u32 t = row[c];
+            if (t == NO_EDGE) {
+                row[c] = fail_row[c];
+                continue;
+            }
+            u32 f = fail_row[c];
+            fail[t] = f;
+            nodes[t].dict = nodes[f].pattern ? f : nodes[f].dict;
+            nodes[t].longest = nodes[t].pattern ? t : nodes[f].longest;
+            queue[tail++] = t;
+        }
+    }
+    free(queue);
+    free(fail);
+
+    // store rows as offsets, so that a scan step is a single add and load.
+    for (size_t i = 0; i < nstates * width; i++)
+        next[i] <<= shift;
+
+    res.next = realloc(next, nstates * width * sizeof(u32));
+    check_alloc(res.next);
+    res.nodes = realloc(nodes, nstates * sizeof(a_matcher_node));
+    check_alloc(res.nodes);
+    res.nstates = nstates;
+    return res;
+}
+
+void a_matcher_free(a_matcher* m) {
+    if (!a_matcher_valid(m))
+        return;
+
+    free(m->next);
+    free(m->nodes);
+    *m = matcher_invalid();
+}
+
+bool a_matcher_valid(const a_matcher* m) {
+    return !(m->nstates == (size_t)-1 || m->next == NULL || m->nodes == NULL);
+}
+
+size_t a_matcher_find_all(const a_matcher* m, a_string_view text,
+                          bool (*on_match)(a_match match, void* ctx),
+                          void* ctx) {
+    if (!a_matcher_valid(m))
+        panic("cannot operate on an invalid a_matcher!");
+
+    const u8* p = (const u8*)text.data;
+    const u32* next = m->next;
+    const a_matcher_node* nodes = m->nodes;
+    u32 shift = m->class_shift;
+    size_t count = 0;
+    u32 s = 0;
+
+    for (size_t i = 0; i < text.len; i++) {
+        s = next[s + m->classes[p[i]]];
+        for (u32 t = nodes[s >> shift].longest; t != 0; t = nodes[t].dict) {
+            a_match match = {
+                .pattern = nodes[t].pattern - 1,
+                .pos = i + 1 - nodes[t].depth,
+                .len = nodes[t].depth,
+            };
+            count++;
+            if (!on_match(match, ctx))
+                return count;
+        }
+    }
+    return count;
+}
+
+bool a_matcher_contains(const a_matcher* m, a_string_view text) {
+    if (!a_matcher_valid(m))
+        panic("cannot operate on an invalid a_matcher!");
+
+    const u8* p = (const u8*)text.data;
+    u32 s = 0;
+    for (size_t i = 0; i < text.len; i++) {
+        s = m->next[s + m->classes[p[i]]];
+        if (m->nodes[s >> m->class_shift].longest != 0)
+            return true;
+    }
+    return false;
+}
+
+a_string a_matcher_replace_all(const a_matcher* m, a_string_view text,
+                               const a_string_view* replacements) {
+    if (!a_matcher_valid(m))
+        panic("cannot operate on an invalid a_matcher!");
+    if (replacements == NULL && m->npatterns != 0)
+        panic("replacements C array is null!");
+
+    a_string res = a_string_with_capacity(text.len + 1);
+    check_alloc(res.data);
+
+    const u8* p = (const u8*)text.data;
+    size_t out = 0, i = 0;
+    u32 s = 0;
+
+    // the leftmost-longest match seen so far that is not written yet.
+    bool pending = false;
+    size_t start = 0, end = 0;
+    u32 pattern = 0;
+
+    for (;;) {
+        if (i < text.len) {
+            s = m->next[s + m->classes[p[i++]]];
+            const a_matcher_node* node = &m->nodes[s >> m->class_shift];
+            if (node->longest != 0) {
+                const a_matcher_node* hit = &m->nodes[node->longest];
+                if (!pending || i - hit->depth <= start) {
+                    pending = true;
+                    start = i - hit->depth;
+                    end = i;
+                    pattern = hit->pattern - 1;
+                }
+            }
+            // the text matched so far starts at i - depth, so until that is
+            // past the pending match, a longer or earlier one may still come.
+            if (!pending || i - node->depth <= start)
+                continue;
+        } else if (!pending) {
+            break;
+        }
+
+        a_string_append_view(&res, (a_string_view){&text.data[out],
+                                                   start - out});
+        a_string_append_view(&res, replacements[pattern]);
+        out = i = end;
+        s = 0;
+        pending = false;
+    }
+
+    a_string_append_view(&res, (a_string_view){&text.data[out],
+                                               text.len - out});
+    return res;
+}
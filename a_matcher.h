@@ -0,0 +1,134 @@
+/*
+ * a_matcher: multi-pattern string search (Aho-Corasick).
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_MATCHER_H
+#define _A_MATCHER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+/**
+ * per-state data of an a_matcher.
+ */
+typedef struct {
+    // length of the text leading to this state.
+    u32 depth;
+
+    // index + 1 of the pattern ending in this state, or 0.
+    u32 pattern;
+
+    // the next state on the failure chain where a pattern ends, or 0.
+    u32 dict;
+
+    // the state of the longest pattern that is a suffix of this one (this
+    // state itself if a pattern ends here), or 0.
+    u32 longest;
+} a_matcher_node;
+
+/**
+ * a set of patterns compiled into an Aho-Corasick automaton, which finds
+ * every occurrence of every pattern in a single pass over a text.
+ *
+ * the automaton is stored as a full DFA, so each byte of text costs one
+ * table lookup. To keep the table small, bytes are first mapped to classes:
+ * every byte that occurs in a pattern gets its own class, and all other bytes
+ * share class 0. Case-insensitive matching (ASCII only) falls out of the
+ * class map, by giving both cases of a letter the same class.
+ */
+typedef struct {
+    // transition table. Entries are state indices pre-shifted by
+    // `class_shift`, so they index straight into the table.
+    u32* next;
+
+    // the states.
+    a_matcher_node* nodes;
+
+    // number of states.
+    size_t nstates;
+
+    // byte to class map.
+    u8 classes[256];
+
+    // log2 of the row width of `next`.
+    u32 class_shift;
+
+    // number of patterns.
+    size_t npatterns;
+} a_matcher;
+
+/**
+ * an occurrence of a pattern.
+ */
+typedef struct {
+    // index of the pattern.
+    size_t pattern;
+
+    // offset of the match in the text.
+    size_t pos;
+
+    // length of the match.
+    size_t len;
+} a_match;
+
+/**
+ * compiles a set of patterns. Patterns must not be empty. If a pattern occurs
+ * more than once, matches are reported for its first index only.
+ *
+ * @param patterns the patterns
+ * @param n the number of patterns
+ * @param ignore_case whether ASCII letters match regardless of case
+ */
+a_matcher a_matcher_new(const a_string_view* patterns, size_t n,
+                        bool ignore_case);
+
+/**
+ * frees a matcher.
+ */
+void a_matcher_free(a_matcher* m);
+
+/**
+ * checks if a matcher is valid.
+ */
+bool a_matcher_valid(const a_matcher* m);
+
+/**
+ * reports every match in a text, including overlapping ones, in order of
+ * their end offsets. Matches ending at the same offset are reported longest
+ * first.
+ *
+ * @param text the text to search
+ * @param on_match called for every match. Returning false stops the search.
+ * @param ctx passed to on_match
+ * @return the number of matches reported
+ */
+size_t a_matcher_find_all(const a_matcher* m, a_string_view text,
+                          bool (*on_match)(a_match match, void* ctx),
+                          void* ctx);
+
+/**
+ * checks if any pattern occurs in a text.
+ */
+bool a_matcher_contains(const a_matcher* m, a_string_view text);
+
+/**
+ * copies a text into a new a_string with every match replaced, in one pass.
+ *
+ * matches do not overlap: the leftmost match wins, and of the matches
+ * starting at the same offset the longest wins. Replaced text is not searched
+ * again.
+ *
+ * @param text the text
+ * @param replacements replacement for each pattern, by pattern index
+ */
+a_string a_matcher_replace_all(const a_matcher* m, a_string_view text,
+                               const a_string_view* replacements);
+
+#endif // _A_MATCHER_H
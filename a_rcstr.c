@@ -0,0 +1,142 @@
+/*
+ * a_rcstr: reference-counted, immutable shared strings.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a_common.h"
+#include "a_rcstr.h"
+
+/*
+ * layout of one allocation:
+ *
+ *   [ bytes ... ][ '\0' ][ padding ][ struct a_rcstr ][ unused capacity ]
+ *   ^ data                          ^ handle
+ *
+ * the handle points at the bookkeeping, and the bytes are found by walking
+ * back from it.
+ */
+struct a_rcstr {
+    _Atomic(size_t) refs;
+    size_t len;
+    // size of the whole allocation, starting at the first byte.
+    size_t alloc_size;
+};
+
+static inline size_t rcstr_offset(size_t len) {
+    const size_t align = _Alignof(struct a_rcstr);
+    return (len + 1 + align - 1) & ~(align - 1);
+}
+
+static inline char* rcstr_bytes(const a_rcstr* rc) {
+    return (char*)rc - rcstr_offset(rc->len);
+}
+
+static a_rcstr* rcstr_init(char* buf, size_t len, size_t alloc_size) {
+    a_rcstr* rc = (a_rcstr*)(buf + rcstr_offset(len));
+    atomic_init(&rc->refs, 1);
+    rc->len = len;
+    rc->alloc_size = alloc_size;
+    return rc;
+}
+
+a_rcstr* a_rcstr_new(const char* data, size_t len) {
+    if (data == NULL && len != 0)
+        panic("source bytes are null!");
+
+    size_t sz = rcstr_offset(len) + sizeof(a_rcstr);
+    char* buf = malloc(sz);
+    check_alloc(buf);
+
+    if (len != 0)
+        memcpy(buf, data, len);
+    buf[len] = '\0';
+    return rcstr_init(buf, len, sz);
+}
+
+a_rcstr* a_rcstr_from_cstr(const char* cstr) {
+    if (cstr == NULL)
+        panic("source C string is null!");
+
+    return a_rcstr_new(cstr, strlen(cstr));
+}
+
+a_rcstr* a_rcstr_from_astr(a_string* s) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    size_t len = s->len;
+    size_t sz = rcstr_offset(len) + sizeof(a_rcstr);
+    char* buf = s->data;
+    if (s->cap < sz) {
+        buf = realloc(buf, sz);
+        check_alloc(buf);
+    } else {
+        sz = s->cap;
+    }
+
+    buf[len] = '\0';
+    *s = a_string_new_invalid();
+    return rcstr_init(buf, len, sz);
+}
+
+a_string a_rcstr_to_astr(a_rcstr* rc) {
+    if (rc == NULL)
+        panic("cannot operate on a null a_rcstr!");
+
+    if (atomic_load_explicit(&rc->refs, memory_order_acquire) == 1) {
+        // we hold the only reference, so nobody else can observe this.
+        a_string res = {
+            .data = rcstr_bytes(rc),
+            .len = rc->len,
+            .cap = rc->alloc_size,
+        };
+        return res;
+    }
+
+    a_string res = a_string_with_capacity(rc->len + 1);
+    memcpy(res.data, rcstr_bytes(rc), rc->len + 1);
+    res.len = rc->len;
+    a_rcstr_release(rc);
+    return res;
+}
+
+a_rcstr* a_rcstr_retain(a_rcstr* rc) {
+    if (rc == NULL)
+        panic("cannot operate on a null a_rcstr!");
+
+    // a new reference can only be made from an existing one, so no ordering
+    // is needed here.
+    atomic_fetch_add_explicit(&rc->refs, 1, memory_order_relaxed);
+    return rc;
+}
+
+void a_rcstr_release(a_rcstr* rc) {
+    if (rc == NULL)
+        return;
+
+    if (atomic_fetch_sub_explicit(&rc->refs, 1, memory_order_release) == 1) {
+        atomic_thread_fence(memory_order_acquire);
+        free(rcstr_bytes(rc));
+    }
+}
+
+const char* a_rcstr_data(const a_rcstr* rc) { return rcstr_bytes(rc); }
+
+size_t a_rcstr_len(const a_rcstr* rc) { return rc->len; }
+
+a_string_view a_rcstr_view(const a_rcstr* rc) {
+    return (a_string_view){.data = rcstr_bytes(rc), .len = rc->len};
+}
+
+size_t a_rcstr_refcount(const a_rcstr* rc) {
+    return atomic_load_explicit(&rc->refs, memory_order_relaxed);
+}
@@ -0,0 +1,110 @@
+/*
+ * a_rcstr: reference-counted, immutable shared strings.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_RCSTR_H
+#define _A_RCSTR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_string.h"
+
+/**
+ * immutable, null terminated string with an atomic reference count.
+ *
+ * the bytes and the bookkeeping live in a single allocation. The bookkeeping
+ * sits *after* the bytes, so an a_string's buffer can be turned into an
+ * a_rcstr (and back) without moving its contents. An a_rcstr can be shared
+ * between threads; each holder calls `a_rcstr_release` once when done.
+ */
+typedef struct a_rcstr a_rcstr;
+
+/**
+ * creates an a_rcstr with a reference count of 1 by copying bytes.
+ *
+ * @param data the bytes to copy
+ * @param len the number of bytes
+ */
+a_rcstr* a_rcstr_new(const char* data, size_t len);
+
+/**
+ * creates an a_rcstr with a reference count of 1 by copying a C string.
+ *
+ * @param cstr the C string
+ */
+a_rcstr* a_rcstr_from_cstr(const char* cstr);
+
+/**
+ * creates an a_rcstr with a reference count of 1 by taking over the buffer of
+ * an a_string. The contents are never copied; the buffer is only grown in
+ * place with realloc if it has no room left for the bookkeeping.
+ *
+ * the source string is left invalid.
+ *
+ * @param s the string to take over
+ */
+a_rcstr* a_rcstr_from_astr(a_string* s);
+
+/**
+ * turns one reference to an a_rcstr back into an a_string.
+ *
+ * if it is the last reference, the buffer is handed over without copying.
+ * Otherwise the bytes are copied and the reference is released.
+ *
+ * @param rc the string, which must not be used by the caller afterwards
+ */
+a_string a_rcstr_to_astr(a_rcstr* rc);
+
+/**
+ * takes another reference to an a_rcstr.
+ *
+ * @param rc the string
+ * @return rc, for convenience
+ */
+a_rcstr* a_rcstr_retain(a_rcstr* rc);
+
+/**
+ * drops a reference to an a_rcstr, freeing it when the last one is dropped.
+ *
+ * passing NULL is a no-op.
+ *
+ * @param rc the string
+ */
+void a_rcstr_release(a_rcstr* rc);
+
+/**
+ * gets the null terminated bytes of an a_rcstr.
+ *
+ * @param rc the string
+ */
+const char* a_rcstr_data(const a_rcstr* rc);
+
+/**
+ * gets the length of an a_rcstr.
+ *
+ * @param rc the string
+ */
+size_t a_rcstr_len(const a_rcstr* rc);
+
+/**
+ * creates a view over an a_rcstr. The view is valid for as long as the caller
+ * holds a reference.
+ *
+ * @param rc the string
+ */
+a_string_view a_rcstr_view(const a_rcstr* rc);
+
+/**
+ * gets the current reference count of an a_rcstr. Only meaningful as a hint
+ * while other threads hold references.
+ *
+ * @param rc the string
+ */
+size_t a_rcstr_refcount(const a_rcstr* rc);
+
+#endif // _A_RCSTR_H
@@ -0,0 +1,155 @@
+/*
+ * a_smallvec: vectors that keep their first few elements inline.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_SMALLVEC_H
+#define _A_SMALLVEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "a_vector.h"
+
+/*
+ * an a_smallvec stores up to N elements inside the struct itself and only
+ * allocates once it outgrows them, so short vectors cost no allocation at
+ * all. Once on the heap, it stays there until it is freed.
+ *
+ * the elements live in the struct while `cap <= N`, so a pointer to them is
+ * not stable across copies of the struct: use `a_smallvec_T_data` instead
+ * of keeping one around.
+ *
+ *     A_SMALLVEC_DECL(u32, 4);     // in a header
+ *     A_SMALLVEC_IMPL(u32, 4)      // in one .c file
+ */
+#define A_SMALLVEC_DECL(T, N)                                                  \
+    typedef struct {                                                           \
+        size_t len;                                                            \
+        size_t cap;                                                            \
+        union {                                                                \
+            T* heap;                                                           \
+            T buf[N];                                                          \
+        } store;                                                               \
+    } a_smallvec_##T;                                                          \
+    a_smallvec_##T a_smallvec_##T##_new(void);                                 \
+    a_smallvec_##T a_smallvec_##T##_with_capacity(size_t cap);                 \
+    a_smallvec_##T a_smallvec_##T##_from_slice(const T* slice,                 \
+                                               size_t nitems);                 \
+    void a_smallvec_##T##_free(a_smallvec_##T* v);                             \
+    bool a_smallvec_##T##_valid(const a_smallvec_##T* v);                      \
+    T* a_smallvec_##T##_data(a_smallvec_##T* v);                               \
+    void a_smallvec_##T##_reserve(a_smallvec_##T* v, size_t cap);              \
+    void a_smallvec_##T##_append(a_smallvec_##T* v, T new_elem);               \
+    void a_smallvec_##T##_append_slice(a_smallvec_##T* v, const T* ptr,        \
+                                       size_t nitems);                         \
+    T a_smallvec_##T##_pop(a_smallvec_##T* v);                                 \
+    T a_smallvec_##T##_pop_at(a_smallvec_##T* v, size_t pos)
+
+/*
+ * implements a small vector whose elements own resources, like
+ * `A_VECTOR_IMPL_DROP`.
+ */
+#define A_SMALLVEC_IMPL(T, N) A_SMALLVEC_IMPL_DROP(T, N, A_VECTOR_NO_DROP)
+#define A_SMALLVEC_IMPL_DROP(T, N, drop_fn)                                    \
+    a_smallvec_##T a_smallvec_##T##_new(void) {                                \
+        return (a_smallvec_##T){.len = 0, .cap = N};                           \
+    }                                                                          \
+    a_smallvec_##T a_smallvec_##T##_with_capacity(size_t cap) {                \
+        a_smallvec_##T res = a_smallvec_##T##_new();                           \
+        a_smallvec_##T##_reserve(&res, cap);                                   \
+        return res;                                                            \
+    }                                                                          \
+    a_smallvec_##T a_smallvec_##T##_from_slice(const T* slice,                 \
+                                               size_t nitems) {                \
+        a_smallvec_##T res = a_smallvec_##T##_new();                           \
+        a_smallvec_##T##_append_slice(&res, slice, nitems);                    \
+        return res;                                                            \
+    }                                                                          \
+    void a_smallvec_##T##_free(a_smallvec_##T* v) {                            \
+        if (a_smallvec_##T##_valid(v)) {                                       \
+            T* data = a_smallvec_##T##_data(v);                                \
+            for (size_t i = 0; i < v->len; i++)                                \
+                drop_fn(&data[i]);                                             \
+            if (v->cap > N)                                                    \
+                free(v->store.heap);                                           \
+        }                                                                      \
+        v->len = (size_t)-1;                                                   \
+        v->cap = (size_t)-1;                                                   \
+    }                                                                          \
+    bool a_smallvec_##T##_valid(const a_smallvec_##T* v) {                     \
+        return !(v->len == (size_t)-1 || v->cap == (size_t)-1);                \
+    }                                                                          \
+    T* a_smallvec_##T##_data(a_smallvec_##T* v) {                              \
+        return v->cap > N ? v->store.heap : v->store.buf;                      \
+    }                                                                          \
+    void a_smallvec_##T##_reserve(a_smallvec_##T* v, size_t cap) {             \
+        if (!a_smallvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (cap <= v->cap)                                                     \
+            return;                                                            \
+        if (v->cap > N) {                                                      \
+            v->store.heap = realloc(v->store.heap, sizeof(T) * cap);           \
+            check_alloc(v->store.heap);                                        \
+        } else {                                                               \
+            T* heap = malloc(sizeof(T) * cap);                                 \
+            check_alloc(heap);                                                 \
+            memcpy(heap, v->store.buf, sizeof(T) * v->len);                    \
+            v->store.heap = heap;                                              \
+        }                                                                      \
+        v->cap = cap;                                                          \
+    }                                                                          \
+    void a_smallvec_##T##_append(a_smallvec_##T* v, T new_elem) {              \
+        if (!a_smallvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (v->len + 1 > v->cap) {                                             \
+            a_smallvec_##T##_reserve(v, v->cap * A_VECTOR_GROWTH_FACTOR);      \
+        }                                                                      \
+        a_smallvec_##T##_data(v)[v->len++] = new_elem;                         \
+    }                                                                          \
+    void a_smallvec_##T##_append_slice(a_smallvec_##T* v, const T* data,       \
+                                       size_t nitems) {                        \
+        if (!a_smallvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        size_t len = v->len + nitems;                                          \
+        if (len > v->cap) {                                                    \
+            size_t sz = v->cap;                                                \
+            while (sz < len)                                                   \
+                sz *= A_VECTOR_GROWTH_FACTOR;                                  \
+            a_smallvec_##T##_reserve(v, sz);                                   \
+        }                                                                      \
+        memcpy(&a_smallvec_##T##_data(v)[v->len], data, sizeof(T) * nitems);   \
+        v->len += nitems;                                                      \
+    }                                                                          \
+    T a_smallvec_##T##_pop(a_smallvec_##T* v) {                                \
+        if (!a_smallvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (v->len == 0) {                                                     \
+            panic("cannot pop from an empty vector");                          \
+        }                                                                      \
+        return a_smallvec_##T##_data(v)[--v->len];                             \
+    }                                                                          \
+    T a_smallvec_##T##_pop_at(a_smallvec_##T* v, size_t pos) {                 \
+        if (!a_smallvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (pos >= v->len) {                                                   \
+            panic("array index %zu out of range", pos);                        \
+        }                                                                      \
+        T* data = a_smallvec_##T##_data(v);                                    \
+        T res = data[pos];                                                     \
+        size_t items = (v->len - pos - 1);                                     \
+        memmove(&data[pos], &data[pos + 1], items * sizeof(T));                \
+        v->len--;                                                              \
+        return res;                                                            \
+    }
+
+#endif // _A_SMALLVEC_H
@@ -0,0 +1,408 @@
+/*
+ * a_snapshot: binary snapshots of vectors and strings, loaded with mmap.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_snapshot.h"
+#include "a_string.h"
+#include "a_writer.h"
+
+#if defined(__x86_64__)
+#define A_SNAPSHOT_X86
+#include <nmmintrin.h>
+#endif
+
+A_VECTOR_IMPL(a_snapshot_entry)
+
+#define SNAPSHOT_MAGIC "ASVSNAP"
+
+// written in native byte order, so it reads back differently on a machine
+// with the other one.
+#define SNAPSHOT_ENDIAN 0x01020304u
+
+typedef struct {
+    char magic[8];
+    u32 version;
+    u32 endian;
+    u64 file_size;
+    u64 nsections;
+    u32 checksum; // CRC32C of everything after the header
+    u32 align;
+    u8 reserved[24];
+} snapshot_header;
+
+_Static_assert(sizeof(snapshot_header) == 64, "header must be 64 bytes");
+_Static_assert(sizeof(a_snapshot_section) == 64, "sections must be 64 bytes");
+_Static_assert(sizeof(a_strvec_slot) == 16, "slots must be 2 u64s");
+
+static const u8 zeros[A_SNAPSHOT_ALIGN];
+
+static inline u64 align_up(u64 n) {
+    return (n + A_SNAPSHOT_ALIGN - 1) & ~(u64)(A_SNAPSHOT_ALIGN - 1);
+}
+
+/*
+ * CRC32C (Castagnoli). x86-64 CPUs with SSE4.2 have an instruction for it,
+ * which handles 8 bytes per step; elsewhere a table is used.
+ */
+static u32 crc_table[256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void crc_table_init(void) {
+    for (u32 i = 0; i < 256; i++) {
+        u32 c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+        crc_table[i] = c;
+    }
+}
+
+static u32 crc32c_table(u32 crc, const u8* p, size_t len) {
+    pthread_once(&crc_table_once, crc_table_init);
+    for (size_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef A_SNAPSHOT_X86
+__attribute__((target("sse4.2"))) static u32 crc32c_sse42(u32 crc, const u8* p,
+                                                          size_t len) {
+    u64 c = crc;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        u64 v;
+        memcpy(&v, &p[i], sizeof(v));
+        c = _mm_crc32_u64(c, v);
+    }
+    crc = (u32)c;
+    for (; i < len; i++)
+        crc = _mm_crc32_u8(crc, p[i]);
+    return crc;
+}
+#endif
+
+// continues a CRC32C. Start with 0xFFFFFFFF and invert the final value.
+static u32 crc32c_update(u32 crc, const void* data, size_t len) {
+#ifdef A_SNAPSHOT_X86
+    if (__builtin_cpu_supports("sse4.2"))
+        return crc32c_sse42(crc, data, len);
+#endif
+    return crc32c_table(crc, data, len);
+}
+
+a_snapshot_writer a_snapshot_writer_new(void) {
+    return (a_snapshot_writer){.entries = a_vector_a_snapshot_entry_new()};
+}
+
+void a_snapshot_writer_free(a_snapshot_writer* w) {
+    a_vector_a_snapshot_entry_free(&w->entries);
+}
+
+static a_snapshot_section section_new(const char* name, a_snapshot_kind kind) {
+    if (name == NULL)
+        panic("section name C string is null!");
+    if (strlen(name) > A_SNAPSHOT_NAME_MAX)
+        panic("section name `%s` is longer than %d chars", name,
+              A_SNAPSHOT_NAME_MAX);
+
+    a_snapshot_section res = {.kind = kind};
+    memcpy(res.name, name, strlen(name));
+    return res;
+}
+
+void a_snapshot_writer_add(a_snapshot_writer* w, const char* name,
+                           const void* data, size_t elem_size, size_t count) {
+    if (data == NULL && count != 0)
+        panic("cannot add a null array!");
+    if (elem_size == 0 || elem_size > UINT32_MAX)
+        panic("invalid element size %zu", elem_size);
+
+    a_snapshot_section section = section_new(name, A_SNAPSHOT_POD);
+    section.elem_size = (u32)elem_size;
+    section.count = count;
+    a_vector_a_snapshot_entry_append(
+        &w->entries, (a_snapshot_entry){.section = section, .data = data});
+}
+
+void a_snapshot_writer_add_strvec(a_snapshot_writer* w, const char* name,
+                                  const a_strvec* v) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+
+    a_snapshot_section section = section_new(name, A_SNAPSHOT_STRINGS);
+    section.elem_size = sizeof(a_strvec_slot);
+    section.count = v->len;
+    section.aux_size = v->bytes_len;
+    a_snapshot_entry entry = {
+        .section = section,
+        .data = v->slots,
+        .aux = v->bytes,
+    };
+    a_vector_a_snapshot_entry_append(&w->entries, entry);
+}
+
+// writes bytes and pads them to the section alignment.
+static bool write_region(a_writer* aw, u32* crc, const void* data, u64 len) {
+    u64 pad = align_up(len) - len;
+    if (len > 0) {
+        *crc = crc32c_update(*crc, data, len);
+        if (!a_writer_write(aw, data, len))
+            return false;
+    }
+    *crc = crc32c_update(*crc, zeros, pad);
+    return a_writer_write(aw, (const char*)zeros, pad);
+}
+
+static bool write_snapshot(a_snapshot_writer* w, int fd) {
+    size_t n = w->entries.len;
+    a_snapshot_entry* entries = w->entries.data;
+
+    // lay the sections out first, so that the table can be written up front.
+    u64 table_end = sizeof(snapshot_header) + n * sizeof(a_snapshot_section);
+    u64 off = align_up(table_end);
+    for (size_t i = 0; i < n; i++) {
+        a_snapshot_section* s = &entries[i].section;
+        s->offset = off;
+        off = align_up(off + s->count * s->elem_size);
+        if (s->kind == A_SNAPSHOT_STRINGS) {
+            s->aux_offset = off;
+            off = align_up(off + s->aux_size);
+        }
+    }
+
+    // the header goes in last, once the checksum is known.
+    snapshot_header header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = A_SNAPSHOT_VERSION,
+        .endian = SNAPSHOT_ENDIAN,
+        .file_size = off,
+        .nsections = n,
+        .align = A_SNAPSHOT_ALIGN,
+    };
+    a_writer aw = a_writer_new(fd);
+    u32 crc = 0xFFFFFFFFu;
+    bool ok = a_writer_write(&aw, (const char*)&header, sizeof(header));
+    for (size_t i = 0; ok && i < n; i++) {
+        const a_snapshot_section* s = &entries[i].section;
+        crc = crc32c_update(crc, s, sizeof(*s));
+        ok = a_writer_write(&aw, (const char*)s, sizeof(*s));
+    }
+    if (ok) {
+        u64 pad = align_up(table_end) - table_end;
+        crc = crc32c_update(crc, zeros, pad);
+        ok = a_writer_write(&aw, (const char*)zeros, pad);
+    }
+    for (size_t i = 0; ok && i < n; i++) {
+        const a_snapshot_section* s = &entries[i].section;
+        ok = write_region(&aw, &crc, entries[i].data, s->count * s->elem_size);
+        if (ok && s->kind == A_SNAPSHOT_STRINGS)
+            ok = write_region(&aw, &crc, entries[i].aux, s->aux_size);
+    }
+    ok = a_writer_free(&aw) && ok;
+    if (!ok)
+        return false;
+
+    header.checksum = ~crc;
+    if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+        return false;
+    return fsync(fd) == 0;
+}
+
+bool a_snapshot_writer_save(a_snapshot_writer* w, const char* path) {
+    if (path == NULL)
+        panic("target file name C string is null!");
+
+    a_string tmp = a_string_asprintf("%s.tmp", path);
+    int fd = open(tmp.data, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        a_string_free(&tmp);
+        return false;
+    }
+
+    bool ok = write_snapshot(w, fd);
+    int err = errno;
+    if (close(fd) != 0 && ok) {
+        ok = false;
+        err = errno;
+    }
+    if (ok && rename(tmp.data, path) != 0) {
+        ok = false;
+        err = errno;
+    }
+    if (!ok)
+        unlink(tmp.data);
+    a_string_free(&tmp);
+    errno = err;
+    return ok;
+}
+
+static a_snapshot snapshot_invalid(int err) {
+    errno = err;
+    return (a_snapshot){.base = NULL, .len = (size_t)-1};
+}
+
+// checks that [off, off + count * size) is an aligned range inside the file.
+static bool range_ok(u64 off, u64 count, u64 size, u64 file_len) {
+    u64 bytes;
+    if (__builtin_mul_overflow(count, size, &bytes))
+        return false;
+    return off % A_SNAPSHOT_ALIGN == 0 && off <= file_len &&
+           bytes <= file_len - off;
+}
+
+static bool section_ok(const a_snapshot* s, const a_snapshot_section* sec,
+                       bool verify) {
+    if (sec->name[A_SNAPSHOT_NAME_MAX] != '\0')
+        return false;
+
+    if (sec->kind == A_SNAPSHOT_POD)
+        return sec->elem_size != 0 &&
+               range_ok(sec->offset, sec->count, sec->elem_size, s->len);
+    if (sec->kind != A_SNAPSHOT_STRINGS)
+        return false;
+
+    if (sec->elem_size != sizeof(a_strvec_slot) ||
+        !range_ok(sec->offset, sec->count, sizeof(a_strvec_slot), s->len) ||
+        !range_ok(sec->aux_offset, sec->aux_size, 1, s->len))
+        return false;
+    if (!verify)
+        return true;
+
+    const a_strvec_slot* slots = (const a_strvec_slot*)&s->base[sec->offset];
+    const char* bytes = (const char*)&s->base[sec->aux_offset];
+    for (u64 i = 0; i < sec->count; i++) {
+        if (slots[i].off >= sec->aux_size ||
+            slots[i].len >= sec->aux_size - slots[i].off ||
+            bytes[slots[i].off + slots[i].len] != '\0')
+            return false;
+    }
+    return true;
+}
+
+a_snapshot a_snapshot_open(const char* path, bool verify) {
+    if (path == NULL)
+        panic("source file name C string is null!");
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return snapshot_invalid(errno);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return snapshot_invalid(err);
+    }
+    if ((size_t)st.st_size < sizeof(snapshot_header)) {
+        close(fd);
+        return snapshot_invalid(EBADMSG);
+    }
+
+    a_snapshot res = {.len = (size_t)st.st_size};
+    void* map = mmap(NULL, res.len, PROT_READ, MAP_PRIVATE, fd, 0);
+    int err = errno;
+    close(fd);
+    if (map == MAP_FAILED)
+        return snapshot_invalid(err);
+    res.base = map;
+
+    snapshot_header header;
+    memcpy(&header, res.base, sizeof(header));
+    bool ok = memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == A_SNAPSHOT_VERSION &&
+              header.endian == SNAPSHOT_ENDIAN &&
+              header.align == A_SNAPSHOT_ALIGN && header.file_size == res.len &&
+              header.nsections <= (res.len - sizeof(header)) /
+                                      sizeof(a_snapshot_section);
+    if (ok) {
+        res.sections = (const a_snapshot_section*)&res.base[sizeof(header)];
+        res.nsections = header.nsections;
+        for (size_t i = 0; ok && i < res.nsections; i++)
+            ok = section_ok(&res, &res.sections[i], verify);
+    }
+    if (ok && verify) {
+        u32 crc = crc32c_update(0xFFFFFFFFu, &res.base[sizeof(header)],
+                                res.len - sizeof(header));
+        ok = ~crc == header.checksum;
+    }
+    if (!ok) {
+        munmap(map, res.len);
+        return snapshot_invalid(EBADMSG);
+    }
+    return res;
+}
+
+void a_snapshot_close(a_snapshot* s) {
+    if (!a_snapshot_valid(s))
+        return;
+
+    munmap((void*)s->base, s->len);
+    *s = (a_snapshot){.base = NULL, .len = (size_t)-1};
+}
+
+bool a_snapshot_valid(const a_snapshot* s) {
+    return !(s->len == (size_t)-1 || s->base == NULL);
+}
+
+static const a_snapshot_section* find_section(const a_snapshot* s,
+                                              const char* name,
+                                              a_snapshot_kind kind) {
+    if (!a_snapshot_valid(s))
+        panic("cannot operate on an invalid a_snapshot!");
+    if (name == NULL)
+        panic("section name C string is null!");
+
+    for (size_t i = 0; i < s->nsections; i++) {
+        if (s->sections[i].kind == (u32)kind &&
+            strcmp(s->sections[i].name, name) == 0)
+            return &s->sections[i];
+    }
+    return NULL;
+}
+
+const void* a_snapshot_get(const a_snapshot* s, const char* name,
+                           size_t elem_size, size_t* count) {
+    const a_snapshot_section* sec = find_section(s, name, A_SNAPSHOT_POD);
+    if (sec == NULL || sec->elem_size != elem_size)
+        return NULL;
+
+    if (count)
+        *count = sec->count;
+    return &s->base[sec->offset];
+}
+
+bool a_snapshot_get_strvec(const a_snapshot* s, const char* name,
+                           a_strvec* out) {
+    const a_snapshot_section* sec = find_section(s, name, A_SNAPSHOT_STRINGS);
+    if (sec == NULL)
+        return false;
+
+    // an a_strvec needs a non-null buffer and slot table even when empty;
+    // both offsets are inside the mapping either way.
+    *out = (a_strvec){
+        .bytes = (char*)&s->base[sec->aux_offset],
+        .bytes_len = sec->aux_size,
+        .bytes_cap = sec->aux_size,
+        .slots = (a_strvec_slot*)&s->base[sec->offset],
+        .len = sec->count,
+        .cap = sec->count,
+    };
+    return true;
+}
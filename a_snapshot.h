@@ -0,0 +1,216 @@
+/*
+ * a_snapshot: binary snapshots of vectors and strings, loaded with mmap.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_SNAPSHOT_H
+#define _A_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_strvec.h"
+#include "a_vector.h"
+
+/*
+ * a snapshot file holds named sections, each either an array of plain old
+ * data (e.g. the contents of an `a_vector_T`) or a collection of strings in
+ * `a_strvec` layout. It is laid out as:
+ *
+ *     header (64 bytes) | section table (64 bytes each) | section data
+ *
+ * every section starts on a 64 byte boundary, so once the file is mapped,
+ * its data can be used in place, with no parsing or copying, whatever its
+ * size. The header holds a format version, a byte order marker, and a CRC32C
+ * of everything after it.
+ *
+ * the format uses the byte order and type sizes of the machine that wrote it,
+ * and files from a machine with a different byte order are rejected.
+ */
+
+// version of the file format written by this library.
+#define A_SNAPSHOT_VERSION 1
+
+// alignment of every section in the file.
+#define A_SNAPSHOT_ALIGN 64
+
+// longest section name, without the null terminator.
+#define A_SNAPSHOT_NAME_MAX 23
+
+/**
+ * kind of data in a section.
+ */
+typedef enum {
+    // an array of `count` elements of `elem_size` bytes.
+    A_SNAPSHOT_POD = 1,
+
+    // `count` strings, stored as a slot table and a byte buffer.
+    A_SNAPSHOT_STRINGS = 2,
+} a_snapshot_kind;
+
+/**
+ * entry of the section table, as stored in the file.
+ */
+typedef struct {
+    // null padded name.
+    char name[A_SNAPSHOT_NAME_MAX + 1];
+
+    // an `a_snapshot_kind`.
+    u32 kind;
+
+    // size of one element of a POD section.
+    u32 elem_size;
+
+    // number of elements or strings.
+    u64 count;
+
+    // file offset of the elements, or of the slot table of a string section.
+    u64 offset;
+
+    // file offset of the bytes of a string section.
+    u64 aux_offset;
+
+    // number of bytes of a string section.
+    u64 aux_size;
+} a_snapshot_section;
+
+/**
+ * a section queued in an a_snapshot_writer. The data it points to is not
+ * copied, and must stay alive until the snapshot is saved.
+ */
+typedef struct {
+    a_snapshot_section section;
+    const void* data;
+    const void* aux;
+} a_snapshot_entry;
+
+A_VECTOR_DECL(a_snapshot_entry);
+
+/**
+ * collects sections and saves them as a snapshot file.
+ */
+typedef struct {
+    // the sections, in file order.
+    a_vector_a_snapshot_entry entries;
+} a_snapshot_writer;
+
+/**
+ * a snapshot file mapped into memory, read-only.
+ */
+typedef struct {
+    // start of the mapping.
+    const u8* base;
+
+    // length of the mapping.
+    size_t len;
+
+    // the section table, inside the mapping.
+    const a_snapshot_section* sections;
+
+    // number of sections.
+    size_t nsections;
+} a_snapshot;
+
+/**
+ * creates an empty snapshot writer.
+ */
+a_snapshot_writer a_snapshot_writer_new(void);
+
+/**
+ * frees a snapshot writer. The data of the sections is not touched.
+ */
+void a_snapshot_writer_free(a_snapshot_writer* w);
+
+/**
+ * queues an array of plain old data, which must not contain pointers.
+ *
+ * @param name the name of the section, at most `A_SNAPSHOT_NAME_MAX` chars
+ * @param data the elements
+ * @param elem_size the size of one element
+ * @param count the number of elements
+ */
+void a_snapshot_writer_add(a_snapshot_writer* w, const char* name,
+                           const void* data, size_t elem_size, size_t count);
+
+// queues the elements of an `a_vector_T` of plain old data.
+#define a_snapshot_writer_add_vector(w, name, v)                               \
+    a_snapshot_writer_add((w), (name), (v)->data, sizeof(*(v)->data), (v)->len)
+
+/**
+ * queues the strings of an a_strvec.
+ *
+ * @param name the name of the section, at most `A_SNAPSHOT_NAME_MAX` chars
+ * @param v the strings
+ */
+void a_snapshot_writer_add_strvec(a_snapshot_writer* w, const char* name,
+                                  const a_strvec* v);
+
+/**
+ * writes every queued section to a file. The data goes to a temporary file
+ * next to it first, which is then renamed over the target, so readers never
+ * see a partial snapshot.
+ *
+ * @param path the path of the file
+ * @return false on failure, with errno set
+ */
+bool a_snapshot_writer_save(a_snapshot_writer* w, const char* path);
+
+/**
+ * maps a snapshot file and checks its header and section table.
+ *
+ * the checksum covers the whole file, so checking it reads all of the data.
+ * Without it, opening takes the same time for any file size, but the data is
+ * trusted as is.
+ *
+ * @param path the path of the file
+ * @param verify whether to check the checksum and every string slot
+ * @return an invalid snapshot on failure, with errno set. Malformed files set
+ *         it to EBADMSG.
+ */
+a_snapshot a_snapshot_open(const char* path, bool verify);
+
+/**
+ * unmaps a snapshot. Every pointer into it becomes invalid.
+ */
+void a_snapshot_close(a_snapshot* s);
+
+/**
+ * checks if a snapshot is valid.
+ */
+bool a_snapshot_valid(const a_snapshot* s);
+
+/**
+ * gets the elements of a POD section, in place.
+ *
+ * @param name the name of the section
+ * @param elem_size the expected size of one element
+ * @param count where to store the number of elements
+ * @return the elements, or NULL if there is no POD section with that name
+ *         and element size
+ */
+const void* a_snapshot_get(const a_snapshot* s, const char* name,
+                           size_t elem_size, size_t* count);
+
+// gets the elements of a POD section as a `const T*`.
+#define a_snapshot_get_array(s, name, T, count)                                \
+    ((const T*)a_snapshot_get((s), (name), sizeof(T), (count)))
+
+/**
+ * gets a string section as an a_strvec that points into the snapshot.
+ *
+ * the result is read-only and borrowed: it may be read with `a_strvec_get`,
+ * iterated over and copied, but it must not be modified, sorted or freed,
+ * and it is only usable until the snapshot is closed.
+ *
+ * @param name the name of the section
+ * @param out where to store the strings
+ * @return false if there is no string section with that name
+ */
+bool a_snapshot_get_strvec(const a_snapshot* s, const char* name,
+                           a_strvec* out);
+
+#endif // _A_SNAPSHOT_H
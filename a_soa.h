@@ -0,0 +1,169 @@
+/*
+ * a_soa: structure-of-arrays containers.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_SOA_H
+#define _A_SOA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "a_vector.h"
+
+/*
+ * an a_soa stores a record type as one array per field instead of one array
+ * of structs, so a loop over one field only pulls that field into the cache
+ * and can be vectorized. The fields are given as an X-macro:
+ *
+ *     #define PARTICLE_FIELDS(X) X(f64, x) X(f64, y) X(u32, id)
+ *     A_SOA_DECL(particle, PARTICLE_FIELDS);   // in a header
+ *     A_SOA_IMPL(particle, PARTICLE_FIELDS)    // in one .c file
+ *
+ * which declares `a_soa_particle_row` (a plain struct with every field) and
+ * `a_soa_particle`, whose `x`, `y` and `id` members point to the arrays. All
+ * arrays share a single allocation, start on an `A_SOA_ALIGN` boundary and
+ * are resized together.
+ */
+
+// alignment of every field array. Must be a power of 2.
+#ifndef A_SOA_ALIGN
+#define A_SOA_ALIGN 64
+#endif
+
+#define A_SOA_ROUND(bytes)                                                     \
+    (((bytes) + (A_SOA_ALIGN - 1)) & ~(size_t)(A_SOA_ALIGN - 1))
+
+// X-macro callbacks used by the generated code.
+#define A_SOA_X_MEMBER(T, field) T field;
+#define A_SOA_X_PTR(T, field) T* field;
+#define A_SOA_X_SIZE(T, field) +A_SOA_ROUND(sizeof(T) * cap)
+#define A_SOA_X_CARVE(T, field)                                                \
+    res.field = (T*)(base + off);                                              \
+    off += A_SOA_ROUND(sizeof(T) * cap);
+#define A_SOA_X_MOVE(T, field)                                                 \
+    memcpy(next.field, v->field, sizeof(T) * v->len);
+#define A_SOA_X_STORE(T, field) v->field[pos] = row.field;
+#define A_SOA_X_LOAD(T, field) row.field = v->field[pos];
+#define A_SOA_X_SHIFT(T, field)                                                \
+    memmove(&v->field[pos], &v->field[pos + 1], items * sizeof(T));
+
+#define A_SOA_DECL(name, FIELDS)                                               \
+    typedef struct {                                                           \
+        FIELDS(A_SOA_X_MEMBER)                                                 \
+    } a_soa_##name##_row;                                                      \
+    typedef struct {                                                           \
+        FIELDS(A_SOA_X_PTR)                                                    \
+        void* block;                                                           \
+        size_t len;                                                            \
+        size_t cap;                                                            \
+    } a_soa_##name;                                                            \
+    a_soa_##name a_soa_##name##_new(void);                                     \
+    a_soa_##name a_soa_##name##_with_capacity(size_t cap);                     \
+    void a_soa_##name##_free(a_soa_##name* v);                                 \
+    bool a_soa_##name##_valid(const a_soa_##name* v);                          \
+    void a_soa_##name##_reserve(a_soa_##name* v, size_t cap);                  \
+    void a_soa_##name##_append(a_soa_##name* v, a_soa_##name##_row row);       \
+    a_soa_##name##_row a_soa_##name##_get(const a_soa_##name* v, size_t pos);  \
+    void a_soa_##name##_set(a_soa_##name* v, size_t pos,                       \
+                            a_soa_##name##_row row);                           \
+    a_soa_##name##_row a_soa_##name##_pop(a_soa_##name* v);                    \
+    a_soa_##name##_row a_soa_##name##_pop_at(a_soa_##name* v, size_t pos)
+
+#define A_SOA_IMPL(name, FIELDS)                                               \
+    a_soa_##name a_soa_##name##_new(void) {                                    \
+        return a_soa_##name##_with_capacity(5);                                \
+    }                                                                          \
+    a_soa_##name a_soa_##name##_with_capacity(size_t cap) {                    \
+        if (cap == 0)                                                          \
+            cap = 1;                                                           \
+        a_soa_##name res = {.len = 0, .cap = cap};                             \
+        size_t bytes = 0 FIELDS(A_SOA_X_SIZE);                                 \
+        res.block = aligned_alloc(A_SOA_ALIGN, bytes);                         \
+        check_alloc(res.block);                                                \
+        char* base = res.block;                                                \
+        size_t off = 0;                                                        \
+        FIELDS(A_SOA_X_CARVE)                                                  \
+        (void)off;                                                             \
+        return res;                                                            \
+    }                                                                          \
+    void a_soa_##name##_free(a_soa_##name* v) {                                \
+        free(v->block);                                                        \
+        v->block = NULL;                                                       \
+        v->len = (size_t)-1;                                                   \
+        v->cap = (size_t)-1;                                                   \
+    }                                                                          \
+    bool a_soa_##name##_valid(const a_soa_##name* v) {                         \
+        return !(v->len == (size_t)-1 || v->cap == (size_t)-1 ||               \
+                 v->block == NULL);                                            \
+    }                                                                          \
+    void a_soa_##name##_reserve(a_soa_##name* v, size_t cap) {                 \
+        if (!a_soa_##name##_valid(v)) {                                        \
+            panic("the soa is invalid");                                       \
+        }                                                                      \
+        if (cap < v->len) {                                                    \
+            panic("capacity %zu is below the length %zu", cap, v->len);        \
+        }                                                                      \
+        a_soa_##name next = a_soa_##name##_with_capacity(cap);                 \
+        FIELDS(A_SOA_X_MOVE)                                                   \
+        next.len = v->len;                                                     \
+        free(v->block);                                                        \
+        *v = next;                                                             \
+    }                                                                          \
+    void a_soa_##name##_append(a_soa_##name* v, a_soa_##name##_row row) {      \
+        if (!a_soa_##name##_valid(v)) {                                        \
+            panic("the soa is invalid");                                       \
+        }                                                                      \
+        if (v->len + 1 > v->cap) {                                             \
+            a_soa_##name##_reserve(v, v->cap * A_VECTOR_GROWTH_FACTOR);        \
+        }                                                                      \
+        size_t pos = v->len++;                                                 \
+        FIELDS(A_SOA_X_STORE)                                                  \
+    }                                                                          \
+    a_soa_##name##_row a_soa_##name##_get(const a_soa_##name* v,               \
+                                          size_t pos) {                        \
+        if (!a_soa_##name##_valid(v)) {                                        \
+            panic("the soa is invalid");                                       \
+        }                                                                      \
+        if (pos >= v->len) {                                                   \
+            panic("array index %zu out of range", pos);                        \
+        }                                                                      \
+        a_soa_##name##_row row;                                                \
+        FIELDS(A_SOA_X_LOAD)                                                   \
+        return row;                                                            \
+    }                                                                          \
+    void a_soa_##name##_set(a_soa_##name* v, size_t pos,                       \
+                            a_soa_##name##_row row) {                          \
+        if (!a_soa_##name##_valid(v)) {                                        \
+            panic("the soa is invalid");                                       \
+        }                                                                      \
+        if (pos >= v->len) {                                                   \
+            panic("array index %zu out of range", pos);                        \
+        }                                                                      \
+        FIELDS(A_SOA_X_STORE)                                                  \
+    }                                                                          \
+    a_soa_##name##_row a_soa_##name##_pop(a_soa_##name* v) {                   \
+        if (!a_soa_##name##_valid(v)) {                                        \
+            panic("the soa is invalid");                                       \
+        }                                                                      \
+        if (v->len == 0) {                                                     \
+            panic("cannot pop from an empty soa");                             \
+        }                                                                      \
+        size_t pos = --v->len;                                                 \
+        a_soa_##name##_row row;                                                \
+        FIELDS(A_SOA_X_LOAD)                                                   \
+        return row;                                                            \
+    }                                                                          \
+    a_soa_##name##_row a_soa_##name##_pop_at(a_soa_##name* v, size_t pos) {    \
+        a_soa_##name##_row row = a_soa_##name##_get(v, pos);                   \
+        size_t items = (v->len - pos - 1);                                     \
+        FIELDS(A_SOA_X_SHIFT)                                                  \
+        v->len--;                                                              \
+        return row;                                                            \
+    }
+
+#endif // _A_SOA_H
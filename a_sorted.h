@@ -0,0 +1,237 @@
+/*
+ * a_sorted: searching and set operations on sorted vectors.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_SORTED_H
+#define _A_SORTED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "a_vector.h"
+
+/*
+ * operations on an `a_vector_T` whose elements are sorted by `less`, a
+ * function or function-like macro taking 2 elements by value and returning
+ * whether the first one goes before the second. The vector must already be
+ * declared and implemented with `A_VECTOR_DECL`/`A_VECTOR_IMPL`.
+ *
+ *     #define U32_LESS(a, b) ((a) < (b))
+ *     A_SORTED_DECL(u32);              // in a header
+ *     A_SORTED_IMPL(u32, U32_LESS)     // in one .c file
+ *
+ * the searches compile to conditional moves instead of branches, so their
+ * cost does not depend on how predictable the keys are.
+ *
+ * `a_eytz_T` is a read-only copy of a sorted vector in Eytzinger (BFS)
+ * order: the children of node k are 2k and 2k + 1. A search walks the
+ * array from the front, and the next few levels share cache lines that are
+ * prefetched while the current one is compared, so large static tables are
+ * searched with far fewer cache misses than with a binary search.
+ */
+#define A_SORTED_DECL(T)                                                       \
+    typedef struct {                                                           \
+        T* data;                                                               \
+        size_t len;                                                            \
+    } a_eytz_##T;                                                              \
+    size_t a_vector_##T##_lower_bound(const a_vector_##T* v, T key);           \
+    size_t a_vector_##T##_upper_bound(const a_vector_##T* v, T key);           \
+    bool a_vector_##T##_binary_search(const a_vector_##T* v, T key);           \
+    size_t a_vector_##T##_insert_sorted(a_vector_##T* v, T elem);              \
+    a_vector_##T a_vector_##T##_merge(const a_vector_##T* a,                   \
+                                      const a_vector_##T* b);                  \
+    a_vector_##T a_vector_##T##_set_union(const a_vector_##T* a,               \
+                                          const a_vector_##T* b);              \
+    a_vector_##T a_vector_##T##_set_intersection(const a_vector_##T* a,        \
+                                                 const a_vector_##T* b);       \
+    a_vector_##T a_vector_##T##_set_difference(const a_vector_##T* a,          \
+                                               const a_vector_##T* b);         \
+    a_eytz_##T a_eytz_##T##_from_sorted(const a_vector_##T* v);                \
+    void a_eytz_##T##_free(a_eytz_##T* e);                                     \
+    const T* a_eytz_##T##_lower_bound(const a_eytz_##T* e, T key);             \
+    bool a_eytz_##T##_contains(const a_eytz_##T* e, T key)
+
+#define A_SORTED_IMPL(T, less)                                                 \
+    size_t a_vector_##T##_lower_bound(const a_vector_##T* v, T key) {          \
+        if (!a_vector_##T##_valid((a_vector_##T*)v)) {                         \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (v->len == 0)                                                       \
+            return 0;                                                          \
+        const T* base = v->data;                                               \
+        size_t n = v->len;                                                     \
+        while (n > 1) {                                                        \
+            size_t half = n / 2;                                               \
+            __builtin_prefetch(&base[half / 2]);                               \
+            __builtin_prefetch(&base[half + half / 2]);                        \
+            base = less(base[half], key) ? &base[half] : base;                 \
+            n -= half;                                                         \
+        }                                                                      \
+        return (size_t)(base - v->data) + (less(*base, key) ? 1 : 0);          \
+    }                                                                          \
+    size_t a_vector_##T##_upper_bound(const a_vector_##T* v, T key) {          \
+        if (!a_vector_##T##_valid((a_vector_##T*)v)) {                         \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (v->len == 0)                                                       \
+            return 0;                                                          \
+        const T* base = v->data;                                               \
+        size_t n = v->len;                                                     \
+        while (n > 1) {                                                        \
+            size_t half = n / 2;                                               \
+            __builtin_prefetch(&base[half / 2]);                               \
+            __builtin_prefetch(&base[half + half / 2]);                        \
+            base = less(key, base[half]) ? base : &base[half];                 \
+            n -= half;                                                         \
+        }                                                                      \
+        return (size_t)(base - v->data) + (less(key, *base) ? 0 : 1);          \
+    }                                                                          \
+    bool a_vector_##T##_binary_search(const a_vector_##T* v, T key) {          \
+        size_t pos = a_vector_##T##_lower_bound(v, key);                       \
+        return pos < v->len && !less(key, v->data[pos]);                       \
+    }                                                                          \
+    size_t a_vector_##T##_insert_sorted(a_vector_##T* v, T elem) {             \
+        size_t pos = a_vector_##T##_upper_bound(v, elem);                      \
+        a_vector_##T##_append(v, elem);                                        \
+        memmove(&v->data[pos + 1], &v->data[pos],                              \
+                (v->len - 1 - pos) * sizeof(T));                               \
+        v->data[pos] = elem;                                                   \
+        return pos;                                                            \
+    }                                                                          \
+    static a_vector_##T a_vector_##T##_sorted_out(const a_vector_##T* a,       \
+                                                  const a_vector_##T* b,       \
+                                                  size_t cap) {                \
+        if (!a_vector_##T##_valid((a_vector_##T*)a) ||                         \
+            !a_vector_##T##_valid((a_vector_##T*)b)) {                         \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        return a_vector_##T##_with_capacity(cap ? cap : 1);                    \
+    }                                                                          \
+    a_vector_##T a_vector_##T##_merge(const a_vector_##T* a,                   \
+                                      const a_vector_##T* b) {                 \
+        a_vector_##T res =                                                     \
+            a_vector_##T##_sorted_out(a, b, a->len + b->len);                  \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a->len && j < b->len) {                                     \
+            bool take_b = less(b->data[j], a->data[i]);                        \
+            res.data[k++] = take_b ? b->data[j] : a->data[i];                  \
+            j += take_b;                                                       \
+            i += !take_b;                                                      \
+        }                                                                      \
+        memcpy(&res.data[k], &a->data[i], (a->len - i) * sizeof(T));           \
+        k += a->len - i;                                                       \
+        memcpy(&res.data[k], &b->data[j], (b->len - j) * sizeof(T));           \
+        res.len = k + (b->len - j);                                            \
+        return res;                                                            \
+    }                                                                          \
+    a_vector_##T a_vector_##T##_set_union(const a_vector_##T* a,               \
+                                          const a_vector_##T* b) {             \
+        a_vector_##T res =                                                     \
+            a_vector_##T##_sorted_out(a, b, a->len + b->len);                  \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a->len && j < b->len) {                                     \
+            if (less(a->data[i], b->data[j])) {                                \
+                res.data[k++] = a->data[i++];                                  \
+            } else if (less(b->data[j], a->data[i])) {                         \
+                res.data[k++] = b->data[j++];                                  \
+            } else {                                                           \
+                res.data[k++] = a->data[i++];                                  \
+                j++;                                                           \
+            }                                                                  \
+        }                                                                      \
+        memcpy(&res.data[k], &a->data[i], (a->len - i) * sizeof(T));           \
+        k += a->len - i;                                                       \
+        memcpy(&res.data[k], &b->data[j], (b->len - j) * sizeof(T));           \
+        res.len = k + (b->len - j);                                            \
+        return res;                                                            \
+    }                                                                          \
+    a_vector_##T a_vector_##T##_set_intersection(const a_vector_##T* a,        \
+                                                 const a_vector_##T* b) {      \
+        size_t cap = a->len < b->len ? a->len : b->len;                        \
+        a_vector_##T res = a_vector_##T##_sorted_out(a, b, cap);               \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a->len && j < b->len) {                                     \
+            if (less(a->data[i], b->data[j])) {                                \
+                i++;                                                           \
+            } else if (less(b->data[j], a->data[i])) {                         \
+                j++;                                                           \
+            } else {                                                           \
+                res.data[k++] = a->data[i++];                                  \
+                j++;                                                           \
+            }                                                                  \
+        }                                                                      \
+        res.len = k;                                                           \
+        return res;                                                            \
+    }                                                                          \
+    a_vector_##T a_vector_##T##_set_difference(const a_vector_##T* a,          \
+                                               const a_vector_##T* b) {        \
+        a_vector_##T res = a_vector_##T##_sorted_out(a, b, a->len);            \
+        size_t i = 0, j = 0, k = 0;                                            \
+        while (i < a->len && j < b->len) {                                     \
+            if (less(a->data[i], b->data[j])) {                                \
+                res.data[k++] = a->data[i++];                                  \
+            } else if (less(b->data[j], a->data[i])) {                         \
+                j++;                                                           \
+            } else {                                                           \
+                i++;                                                           \
+                j++;                                                           \
+            }                                                                  \
+        }                                                                      \
+        memcpy(&res.data[k], &a->data[i], (a->len - i) * sizeof(T));           \
+        res.len = k + (a->len - i);                                            \
+        return res;                                                            \
+    }                                                                          \
+    static size_t a_eytz_##T##_fill(a_eytz_##T* e, const T* src, size_t i,     \
+                                    size_t k) {                                \
+        if (k <= e->len) {                                                     \
+            i = a_eytz_##T##_fill(e, src, i, 2 * k);                           \
+            e->data[k] = src[i++];                                             \
+            i = a_eytz_##T##_fill(e, src, i, 2 * k + 1);                       \
+        }                                                                      \
+        return i;                                                              \
+    }                                                                          \
+    a_eytz_##T a_eytz_##T##_from_sorted(const a_vector_##T* v) {               \
+        if (!a_vector_##T##_valid((a_vector_##T*)v)) {                         \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        /* slot 0 is unused, so the root is at 1. */                           \
+        size_t bytes = sizeof(T) * (v->len + 1);                               \
+        bytes = (bytes + 63) & ~(size_t)63;                                    \
+        a_eytz_##T res = {.len = v->len};                                      \
+        res.data = aligned_alloc(64, bytes);                                   \
+        check_alloc(res.data);                                                 \
+        a_eytz_##T##_fill(&res, v->data, 0, 1);                                \
+        return res;                                                            \
+    }                                                                          \
+    void a_eytz_##T##_free(a_eytz_##T* e) {                                    \
+        free(e->data);                                                         \
+        e->data = NULL;                                                        \
+        e->len = (size_t)-1;                                                   \
+    }                                                                          \
+    const T* a_eytz_##T##_lower_bound(const a_eytz_##T* e, T key) {            \
+        if (e->data == NULL) {                                                 \
+            panic("the table is invalid");                                     \
+        }                                                                      \
+        /* the descendants of k a few levels down are contiguous, starting */  \
+        /* at k * stride, so one prefetch covers a whole level of them. */     \
+        const size_t stride = sizeof(T) < 64 ? 64 / sizeof(T) : 1;             \
+        size_t k = 1;                                                          \
+        while (k <= e->len) {                                                  \
+            __builtin_prefetch(&e->data[k * stride]);                          \
+            k = 2 * k + (less(e->data[k], key) ? 1 : 0);                       \
+        }                                                                      \
+        /* undo the right turns taken after the last left turn. */             \
+        k >>= __builtin_ffsll((long long)~k);                                  \
+        return k ? &e->data[k] : NULL;                                         \
+    }                                                                          \
+    bool a_eytz_##T##_contains(const a_eytz_##T* e, T key) {                   \
+        const T* found = a_eytz_##T##_lower_bound(e, key);                     \
+        return found && !less(key, *found);                                    \
+    }
+
+#endif // _A_SORTED_H
@@ -10,6 +10,7 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,13 +19,150 @@
 #include "a_common.h"
 #include "a_string.h"
 
+A_VECTOR_IMPL_DROP(a_string, a_string_free)
+
+/*
+ * per-thread cache of string buffers, in power of 2 size classes starting at
+ * 8 bytes. A cached buffer holds the link to the next one of its class in its
+ * first bytes.
+ */
+#define CACHE_MIN_SHIFT 3
+#define CACHE_CLASSES   32
+
+typedef struct cache_node {
+    struct cache_node* next;
+} cache_node;
+
+typedef struct {
+    bool enabled;
+    a_string_cache_config config;
+    cache_node* lists[CACHE_CLASSES];
+    size_t counts[CACHE_CLASSES];
+    a_string_cache_stats stats;
+} buf_cache;
+
+static _Thread_local buf_cache cache;
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+static inline size_t class_size(int c) {
+    return (size_t)1 << (c + CACHE_MIN_SHIFT);
+}
+
+// the smallest class that fits n bytes, or -1 if such buffers are not cached.
+static int class_up(size_t n) {
+    if (!cache.enabled || n > cache.config.max_block)
+        return -1;
+    if (n <= class_size(0))
+        return 0;
+
+    int c = 64 - __builtin_clzll(n - 1) - CACHE_MIN_SHIFT;
+    return class_size(c) <= cache.config.max_block ? c : -1;
+}
+
+/*
+ * allocates a string buffer of at least *cap bytes. If it is cacheable, *cap
+ * is rounded up to its size class, so it can be cached once it is freed.
+ */
+static char* buf_alloc(size_t* cap, bool zero) {
+    int c = class_up(*cap);
+    if (c >= 0) {
+        *cap = class_size(c);
+        cache_node* node = cache.lists[c];
+        if (node != NULL) {
+            cache.lists[c] = node->next;
+            cache.counts[c]--;
+            cache.stats.hits++;
+            cache.stats.buffers--;
+            cache.stats.bytes -= *cap;
+            if (zero)
+                memset(node, 0, *cap);
+            return (char*)node;
+        }
+        cache.stats.misses++;
+    }
+    return zero ? calloc(*cap, 1) : malloc(*cap);
+}
+
+// gives back a buffer of at least cap bytes.
+static void buf_release(char* data, size_t cap) {
+    if (cache.enabled && data != NULL && cap >= class_size(0)) {
+        // round down, so buffers from anywhere else fit their class too.
+        int c = 63 - __builtin_clzll(cap) - CACHE_MIN_SHIFT;
+        size_t size = class_size(c);
+        if (size <= cache.config.max_block) {
+            if (cache.counts[c] < cache.config.max_per_class &&
+                cache.stats.bytes + size <= cache.config.max_bytes) {
+                cache_node* node = (cache_node*)data;
+                node->next = cache.lists[c];
+                cache.lists[c] = node;
+                cache.counts[c]++;
+                cache.stats.kept++;
+                cache.stats.buffers++;
+                cache.stats.bytes += size;
+                return;
+            }
+            cache.stats.dropped++;
+        }
+    }
+    free(data);
+}
+
+static void cache_thread_exit(void* arg) {
+    (void)arg;
+    a_string_cache_disable();
+}
+
+static void cache_make_key(void) {
+    pthread_key_create(&cache_key, cache_thread_exit);
+}
+
+void a_string_cache_enable(const a_string_cache_config* config) {
+    a_string_cache_config cfg = {
+        .max_block = 64 * 1024,
+        .max_per_class = 64,
+        .max_bytes = 4 * 1024 * 1024,
+    };
+    if (config != NULL)
+        cfg = *config;
+    if (cfg.max_block > class_size(CACHE_CLASSES - 1))
+        cfg.max_block = class_size(CACHE_CLASSES - 1);
+
+    // the key's destructor releases the buffers when the thread exits.
+    pthread_once(&cache_key_once, cache_make_key);
+    pthread_setspecific(cache_key, &cache);
+
+    cache.config = cfg;
+    cache.enabled = true;
+}
+
+void a_string_cache_disable(void) {
+    a_string_cache_trim(0);
+    cache.enabled = false;
+}
+
+void a_string_cache_trim(size_t keep_bytes) {
+    for (int c = CACHE_CLASSES - 1; c >= 0; c--) {
+        while (cache.stats.bytes > keep_bytes && cache.lists[c] != NULL) {
+            cache_node* node = cache.lists[c];
+            cache.lists[c] = node->next;
+            cache.counts[c]--;
+            cache.stats.buffers--;
+            cache.stats.bytes -= class_size(c);
+            free(node);
+        }
+    }
+}
+
+a_string_cache_stats a_string_cache_get_stats(void) { return cache.stats; }
+
 a_string a_string_new(void) {
     a_string res = {
         .len = 0,
         .cap = 8,
     };
 
-    res.data = calloc(res.cap, 1); // sizeof(char)
+    res.data = buf_alloc(&res.cap, true);
     if (res.data == NULL)
         return a_string_new_invalid();
 
@@ -34,7 +172,7 @@ a_string a_string_new(void) {
 a_string a_string_with_capacity(size_t cap) {
     a_string res = {.len = 0, .cap = cap};
 
-    res.data = calloc(res.cap, 1); // sizeof(char)
+    res.data = buf_alloc(&res.cap, true);
     if (res.data == NULL)
         return a_string_new_invalid();
 
@@ -48,7 +186,7 @@ void a_string_free(a_string* s) {
         return;
     }
 
-    free(s->data);
+    buf_release(s->data, s->cap);
 
     s->len = -1;
     s->cap = -1;
@@ -122,6 +260,21 @@ void a_string_reserve(a_string* s, size_t cap) {
     if (s->cap == cap)
         return;
 
+    int c = class_up(cap);
+    if (c >= 0) {
+        // move to a buffer of the new class, so the old one can be reused.
+        if (class_size(c) == s->cap)
+            return;
+        size_t new_cap = cap;
+        char* data = buf_alloc(&new_cap, false);
+        check_alloc(data);
+        memcpy(data, s->data, s->cap < new_cap ? s->cap : new_cap);
+        buf_release(s->data, s->cap);
+        s->data = data;
+        s->cap = new_cap;
+        return;
+    }
+
     s->data = realloc(s->data, cap);
     check_alloc(s->data);
     s->cap = cap;
@@ -137,7 +290,7 @@ a_string a_string_from_cstr(const char* cstr) {
         .len = strlen(cstr),
     };
 
-    res.data = calloc(res.cap, 1); // sizeof(char)
+    res.data = buf_alloc(&res.cap, true);
     strcpy(res.data, cstr);
 
     return res;
@@ -466,14 +619,25 @@ void a_string_inplace_trim(a_string* s) {
         memset(&s->data[end], 0, oldlen - s->len + 1);
 }
 
+// unlike toupper/tolower, these ignore the locale and never touch bytes
+// outside of ASCII, which would corrupt UTF-8.
+static inline char ascii_toupper(char c) {
+    return (c >= 'a' && c <= 'z') ? (char)(c - 32) : c;
+}
+
+static inline char ascii_tolower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+}
+
 a_string a_string_toupper(const a_string* s) {
     if (!a_string_valid(s))
         panic("cannot operate on an invalid a_string!");
 
     a_string res = a_string_with_capacity(s->cap);
     for (size_t i = 0; i < s->len; i++) {
-        res.data[i] = toupper(s->data[i]);
+        res.data[i] = ascii_toupper(s->data[i]);
     }
+    res.len = s->len;
     return res;
 }
 
@@ -483,8 +647,9 @@ a_string a_string_tolower(const a_string* s) {
 
     a_string res = a_string_with_capacity(s->cap);
     for (size_t i = 0; i < s->len; i++) {
-        res.data[i] = tolower(s->data[i]);
+        res.data[i] = ascii_tolower(s->data[i]);
     }
+    res.len = s->len;
     return res;
 }
 
@@ -493,7 +658,7 @@ void a_string_inplace_toupper(a_string* s) {
         panic("cannot operate on an invalid a_string!");
 
     for (size_t i = 0; i < s->len; i++) {
-        s->data[i] = toupper(s->data[i]);
+        s->data[i] = ascii_toupper(s->data[i]);
     }
 }
 
@@ -502,7 +667,7 @@ void a_string_inplace_tolower(a_string* s) {
         panic("cannot operate on an invalid a_string!");
 
     for (size_t i = 0; i < s->len; i++) {
-        s->data[i] = tolower(s->data[i]);
+        s->data[i] = ascii_tolower(s->data[i]);
     }
 }
 
@@ -513,17 +678,7 @@ bool a_string_equal(const a_string* lhs, const a_string* rhs) {
     if (!a_string_valid(rhs))
         panic("cannot compare an invalid a_string!");
 
-    if (lhs->len != rhs->len) {
-        return false;
-    }
-
-    for (size_t i = 0; i < lhs->len; i++) {
-        if (lhs->data[i] != rhs->data[i]) {
-            return false;
-        }
-    }
-
-    return true;
+    return a_string_bytes_equal(lhs->data, lhs->len, rhs->data, rhs->len);
 }
 
 bool a_string_equal_cstr(const a_string* lhs, const char* rhs) {
@@ -543,17 +698,7 @@ bool a_string_equal_case_insensitive(const a_string* lhs, const a_string* rhs) {
     if (!a_string_valid(rhs))
         panic("cannot compare an invalid a_string!");
 
-    if (lhs->len != rhs->len) {
-        return false;
-    }
-
-    for (size_t i = 0; i < lhs->len; i++) {
-        if (tolower(lhs->data[i]) != tolower(rhs->data[i])) {
-            return false;
-        }
-    }
-
-    return true;
+    return a_string_utf8_equal_fold(lhs->data, lhs->len, rhs->data, rhs->len);
 }
 
 bool a_string_equal_case_insensitive_cstr(const a_string* lhs,
@@ -566,3 +711,50 @@ bool a_string_equal_case_insensitive_cstr(const a_string* lhs,
     }; // very sketchy, i know
     return a_string_equal_case_insensitive(lhs, &arhs);
 }
+
+a_string a_string_take(a_string* s) {
+    a_string res = *s;
+    *s = a_string_new_invalid();
+    return res;
+}
+
+a_string a_string_from_raw(char* data, size_t len, size_t cap) {
+    if (data == NULL)
+        panic("cannot build an a_string from a null buffer!");
+    if (len >= cap)
+        panic("no room for the null terminator in the buffer!");
+
+    data[len] = '\0';
+    return (a_string){.data = data, .len = len, .cap = cap};
+}
+
+a_string_view a_string_as_view(const a_string* s) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    return (a_string_view){.data = s->data, .len = s->len};
+}
+
+a_string_view a_sv(const char* cstr) {
+    if (cstr == NULL)
+        panic("source C string is null!");
+
+    return (a_string_view){.data = cstr, .len = strlen(cstr)};
+}
+
+void a_string_append_view(a_string* s, a_string_view v) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    size_t required_cap = s->len + v.len + 1;
+    if (required_cap > s->cap) {
+        size_t cap = (s->cap == 0) ? 8 : s->cap;
+        while (cap < required_cap)
+            cap *= 2;
+        a_string_reserve(s, cap);
+    }
+
+    memcpy(&s->data[s->len], v.data, v.len);
+    s->len += v.len;
+    s->data[s->len] = '\0';
+}
@@ -14,6 +14,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "a_common.h"
+#include "a_vector.h"
+
 /**
  * null terminated, heap-allocated string slice.
  */
@@ -28,6 +31,99 @@ typedef struct {
     size_t cap;
 } a_string;
 
+// vector of a_strings. Freeing it frees every string in it.
+A_VECTOR_DECL(a_string);
+
+/**
+ * non-owning, read-only view into a run of bytes. It is not necessarily null
+ * terminated, and must not outlive the buffer it points into.
+ */
+typedef struct {
+    // pointer to the first byte of the view.
+    const char* data;
+
+    // length of the view.
+    size_t len;
+} a_string_view;
+
+// maximum number of chars written by `a_string_fmt_i64`/`a_string_fmt_u64`.
+#define A_STRING_INT_MAX_CHARS 20
+
+// maximum number of chars written by `a_string_fmt_hex`.
+#define A_STRING_HEX_MAX_CHARS 16
+
+// maximum number of chars written by `a_string_fmt_f64`.
+#define A_STRING_F64_MAX_CHARS 25
+
+/**
+ * iterator over the codepoints of a UTF-8 encoded run of bytes. Create one
+ * with `a_string_utf8_iter_new` and advance it with `a_string_utf8_next`.
+ */
+typedef struct {
+    // the bytes being iterated over.
+    const char* data;
+
+    // length of the bytes.
+    size_t len;
+
+    // byte offset of the next codepoint.
+    size_t pos;
+} a_string_utf8_iter;
+
+/**
+ * result of the `a_string_parse_*` family.
+ */
+typedef enum {
+    // the whole input was parsed.
+    A_PARSE_OK = 0,
+
+    // the input had a length of 0.
+    A_PARSE_EMPTY,
+
+    // the input contains characters that are not part of a number.
+    A_PARSE_INVALID,
+
+    // the number does not fit in the target type.
+    A_PARSE_OVERFLOW,
+} a_parse_status;
+
+/**
+ * limits of the per-thread buffer cache. See `a_string_cache_enable`.
+ */
+typedef struct {
+    // largest buffer that is cached. Larger buffers go straight to malloc.
+    size_t max_block;
+
+    // most buffers kept per size class.
+    size_t max_per_class;
+
+    // most bytes kept in total.
+    size_t max_bytes;
+} a_string_cache_config;
+
+/**
+ * counters of the calling thread's buffer cache.
+ */
+typedef struct {
+    // allocations served from the cache.
+    size_t hits;
+
+    // cacheable allocations that had to go to malloc.
+    size_t misses;
+
+    // freed buffers that were kept.
+    size_t kept;
+
+    // freed buffers that went back to free because the cache was full.
+    size_t dropped;
+
+    // number of buffers in the cache.
+    size_t buffers;
+
+    // number of bytes in the cache.
+    size_t bytes;
+} a_string_cache_stats;
+
 /**
  * creates and initializes an empty, valid a_string. If you would like to create
  * an uninitialized and invalid a_string, use `a_string_new_uninitialized`.
@@ -225,6 +321,26 @@ bool a_string_read_line(a_string* buf, FILE* restrict stream);
  */
 a_string a_string_read_file(const char* filename);
 
+/**
+ * reads the entirety of many files at once.
+ *
+ * on Linux, opens, size queries and reads for all files are queued through
+ * io_uring, so they overlap instead of running one after another. When
+ * io_uring is unavailable (or on other systems), a pool of worker threads
+ * reads the files instead. Define `A_STRING_NO_IO_URING` to always use the
+ * pool.
+ *
+ * the result has one entry per path, in order. Files that could not be read
+ * are left as invalid a_strings.
+ *
+ * @param paths the file names
+ * @param n the number of file names
+ * @param errs if not NULL, an array of n ints that receives 0 or the errno
+ * value for each file
+ */
+a_vector_a_string a_string_read_files(const char* const* paths, size_t n,
+                                      int* errs);
+
 /**
  * gets a string input from stdin into an a_string with a non-formatted prompt.
  *
@@ -352,14 +468,16 @@ void a_string_inplace_trim_right(a_string* s);
 void a_string_inplace_trim(a_string* s);
 
 /**
- * converts all the characters in the a_string to uppercase.
+ * converts all the ASCII characters in the a_string to uppercase. Bytes
+ * outside of ASCII are left untouched, so UTF-8 text stays intact.
  *
  * @param s the string
  */
 a_string a_string_toupper(const a_string* s);
 
 /**
- * converts all the characters in the a_string to lowercase.
+ * converts all the ASCII characters in the a_string to lowercase. Bytes
+ * outside of ASCII are left untouched, so UTF-8 text stays intact.
  *
  * @param s the string
  */
@@ -388,7 +506,42 @@ void a_string_inplace_tolower(a_string* s);
 bool a_string_equal(const a_string* lhs, const a_string* rhs);
 
 /**
- * checks if 2 a_strings are the same, case insensitive.
+ * compares 2 a_strings byte by byte, like memcmp. A string that is a prefix
+ * of the other one sorts first.
+ *
+ * @param lhs the first string
+ * @param rhs the other string
+ * @return -1, 0 or 1 if lhs is less than, equal to or greater than rhs
+ */
+int a_string_compare(const a_string* lhs, const a_string* rhs);
+
+/**
+ * finds the length of the longest common prefix of 2 a_strings, in bytes.
+ *
+ * @param lhs the first string
+ * @param rhs the other string
+ */
+size_t a_string_common_prefix(const a_string* lhs, const a_string* rhs);
+
+/**
+ * checks if an a_string starts with a prefix.
+ *
+ * @param s the string
+ * @param prefix the prefix
+ */
+bool a_string_starts_with(const a_string* s, a_string_view prefix);
+
+/**
+ * checks if an a_string ends with a suffix.
+ *
+ * @param s the string
+ * @param suffix the suffix
+ */
+bool a_string_ends_with(const a_string* s, a_string_view suffix);
+
+/**
+ * checks if 2 a_strings are the same, case insensitive. Both strings are
+ * treated as UTF-8, see `a_string_utf8_equal_fold`.
  *
  * @param lhs the first string
  * @param rhs the other string
@@ -396,4 +549,332 @@ bool a_string_equal(const a_string* lhs, const a_string* rhs);
 
 bool a_string_equal_case_insensitive(const a_string* lhs, const a_string* rhs);
 
+/**
+ * moves the buffer out of an a_string without copying it. The source is left
+ * invalid, and the caller becomes responsible for freeing the result.
+ *
+ * @param s the string to take from
+ */
+a_string a_string_take(a_string* s);
+
+/**
+ * creates an a_string that takes ownership of an existing heap buffer,
+ * without copying it. A null terminator is written at data[len].
+ *
+ * @param data a buffer allocated with malloc/calloc/realloc
+ * @param len the length of the string in the buffer
+ * @param cap the size of the buffer, which must be greater than len
+ */
+a_string a_string_from_raw(char* data, size_t len, size_t cap);
+
+/**
+ * creates a view over an a_string. The view is invalidated once the string is
+ * modified or freed.
+ *
+ * @param s the string
+ */
+a_string_view a_string_as_view(const a_string* s);
+
+/**
+ * creates a view over a C string.
+ *
+ * @param cstr the C string
+ */
+a_string_view a_sv(const char* cstr);
+
+/**
+ * concatenates the bytes of a view to an a_string.
+ *
+ * @param s the target string to be concatenated
+ * @param v the view to add on
+ */
+void a_string_append_view(a_string* s, a_string_view v);
+
+/**
+ * formats a signed integer into a caller-provided buffer, without going
+ * through printf. No null terminator is written.
+ *
+ * @param buf a buffer of at least `A_STRING_INT_MAX_CHARS` bytes
+ * @param value the value
+ * @return a view over the formatted digits inside buf
+ */
+a_string_view a_string_fmt_i64(char* buf, i64 value);
+
+/**
+ * formats an unsigned integer into a caller-provided buffer, without going
+ * through printf. No null terminator is written.
+ *
+ * @param buf a buffer of at least `A_STRING_INT_MAX_CHARS` bytes
+ * @param value the value
+ * @return a view over the formatted digits inside buf
+ */
+a_string_view a_string_fmt_u64(char* buf, u64 value);
+
+/**
+ * formats an unsigned integer as lowercase hex (without a `0x` prefix) into a
+ * caller-provided buffer. No null terminator is written.
+ *
+ * @param buf a buffer of at least `A_STRING_HEX_MAX_CHARS` bytes
+ * @param value the value
+ * @return a view over the formatted digits inside buf
+ */
+a_string_view a_string_fmt_hex(char* buf, u64 value);
+
+/**
+ * formats a double into a caller-provided buffer (Grisu2). The output always
+ * parses back to the exact same value, and is the shortest such
+ * representation in nearly all cases; rarely, a longer one is written, e.g.
+ * `9.999999999999999e+22` for 1e23. Large and small magnitudes use exponent
+ * notation, like `1.5e+300`. NaN and infinities
+ * are written as `nan`, `inf` and `-inf`. No null terminator is written.
+ *
+ * @param buf a buffer of at least `A_STRING_F64_MAX_CHARS` bytes
+ * @param value the value
+ * @return a view over the formatted chars inside buf
+ */
+a_string_view a_string_fmt_f64(char* buf, f64 value);
+
+/**
+ * appends a signed integer in decimal to an a_string.
+ *
+ * @param s the target string
+ * @param value the value
+ */
+void a_string_append_i64(a_string* s, i64 value);
+
+/**
+ * appends an unsigned integer in decimal to an a_string.
+ *
+ * @param s the target string
+ * @param value the value
+ */
+void a_string_append_u64(a_string* s, u64 value);
+
+/**
+ * appends an unsigned integer in lowercase hex to an a_string.
+ *
+ * @param s the target string
+ * @param value the value
+ */
+void a_string_append_hex(a_string* s, u64 value);
+
+/**
+ * appends a round-trip representation of a double to an a_string, which is
+ * the shortest one in nearly all cases. see `a_string_fmt_f64` for the output
+ * format.
+ *
+ * @param s the target string
+ * @param value the value
+ */
+void a_string_append_f64(a_string* s, f64 value);
+
+/**
+ * parses a signed decimal integer from a run of bytes.
+ *
+ * the entire input must be an optional `+` or `-` followed by digits; no
+ * whitespace is skipped and the input does not need to be null terminated.
+ * `out` is only written to on success.
+ *
+ * @param data the bytes to parse
+ * @param len the number of bytes
+ * @param out where the result is stored
+ */
+a_parse_status a_string_parse_i64(const char* data, size_t len, i64* out);
+
+/**
+ * parses an unsigned decimal integer from a run of bytes.
+ *
+ * the entire input must be an optional `+` followed by digits; no whitespace
+ * is skipped and the input does not need to be null terminated. `out` is only
+ * written to on success.
+ *
+ * @param data the bytes to parse
+ * @param len the number of bytes
+ * @param out where the result is stored
+ */
+a_parse_status a_string_parse_u64(const char* data, size_t len, u64* out);
+
+/**
+ * parses a decimal floating point number from a run of bytes, rounding to
+ * nearest like strtod.
+ *
+ * accepts `[+-]digits[.digits][(e|E)[+-]digits]`, as well as `inf`,
+ * `infinity` and `nan` in any case. The decimal point is always `.`,
+ * regardless of locale. No whitespace is skipped and the input does not need
+ * to be null terminated. Values too large for a double return
+ * `A_PARSE_OVERFLOW` and store an infinity in `out`; otherwise `out` is only
+ * written to on success.
+ *
+ * @param data the bytes to parse
+ * @param len the number of bytes
+ * @param out where the result is stored
+ */
+a_parse_status a_string_parse_f64(const char* data, size_t len, f64* out);
+
+/**
+ * checks if a run of bytes is valid UTF-8. Overlong encodings, surrogates and
+ * codepoints past U+10FFFF are rejected.
+ *
+ * uses SSSE3 when the CPU supports it, and skips over ASCII 64 bytes at a
+ * time.
+ *
+ * @param data the bytes to check
+ * @param len the number of bytes
+ */
+bool a_string_utf8_valid(const char* data, size_t len);
+
+/**
+ * counts the codepoints in a run of valid UTF-8. For invalid input, this is
+ * the number of bytes that are not continuation bytes.
+ *
+ * @param data the bytes
+ * @param len the number of bytes
+ */
+size_t a_string_utf8_count(const char* data, size_t len);
+
+/**
+ * creates a codepoint iterator over a run of UTF-8.
+ *
+ * @param data the bytes
+ * @param len the number of bytes
+ */
+a_string_utf8_iter a_string_utf8_iter_new(const char* data, size_t len);
+
+/**
+ * decodes the next codepoint of an iterator. Invalid sequences decode to
+ * U+FFFD and skip a single byte.
+ *
+ * @param it the iterator
+ * @param cp where the codepoint is stored
+ * @return false once the end of the input has been reached
+ */
+bool a_string_utf8_next(a_string_utf8_iter* it, u32* cp);
+
+/**
+ * simple (1:1) Unicode case folding of a codepoint. Covers ASCII, Latin-1,
+ * Latin Extended-A and Additional, Greek, Cyrillic, Armenian, Georgian,
+ * Glagolitic, Deseret and fullwidth Latin; other codepoints are returned
+ * unchanged.
+ *
+ * @param cp the codepoint
+ */
+u32 a_string_utf8_fold(u32 cp);
+
+/**
+ * checks if 2 runs of UTF-8 are equal under `a_string_utf8_fold`. ASCII is
+ * compared eight bytes at a time. Invalid bytes only match themselves.
+ *
+ * @param lhs the first string
+ * @param lhs_len the length of the first string
+ * @param rhs the other string
+ * @param rhs_len the length of the other string
+ */
+bool a_string_utf8_equal_fold(const char* lhs, size_t lhs_len,
+                              const char* rhs, size_t rhs_len);
+
+/**
+ * finds the index of the first byte at which 2 runs of bytes differ.
+ *
+ * compares 64 bytes per step with SSE2, or AVX2 when the CPU supports it.
+ * Runs shorter than 16 bytes are compared with overlapping word loads.
+ *
+ * @param lhs the first run
+ * @param rhs the other run
+ * @param len the number of bytes of both runs
+ * @return the index of the first difference, or len if they are equal
+ */
+size_t a_string_bytes_mismatch(const char* lhs, const char* rhs, size_t len);
+
+/**
+ * finds the length of the longest common prefix of 2 runs of bytes.
+ *
+ * @param lhs the first run
+ * @param lhs_len the length of the first run
+ * @param rhs the other run
+ * @param rhs_len the length of the other run
+ */
+size_t a_string_bytes_common_prefix(const char* lhs, size_t lhs_len,
+                                    const char* rhs, size_t rhs_len);
+
+/**
+ * checks if 2 runs of bytes are equal.
+ *
+ * @param lhs the first run
+ * @param lhs_len the length of the first run
+ * @param rhs the other run
+ * @param rhs_len the length of the other run
+ */
+bool a_string_bytes_equal(const char* lhs, size_t lhs_len, const char* rhs,
+                          size_t rhs_len);
+
+/**
+ * compares 2 runs of bytes like memcmp, with the shorter run sorting first
+ * if it is a prefix of the other one.
+ *
+ * @param lhs the first run
+ * @param lhs_len the length of the first run
+ * @param rhs the other run
+ * @param rhs_len the length of the other run
+ * @return -1, 0 or 1 if lhs is less than, equal to or greater than rhs
+ */
+int a_string_bytes_compare(const char* lhs, size_t lhs_len, const char* rhs,
+                           size_t rhs_len);
+
+/**
+ * checks if a run of bytes starts with a prefix.
+ *
+ * @param data the bytes
+ * @param len the number of bytes
+ * @param prefix the prefix
+ * @param prefix_len the length of the prefix
+ */
+bool a_string_bytes_starts_with(const char* data, size_t len,
+                                const char* prefix, size_t prefix_len);
+
+/**
+ * checks if a run of bytes ends with a suffix.
+ *
+ * @param data the bytes
+ * @param len the number of bytes
+ * @param suffix the suffix
+ * @param suffix_len the length of the suffix
+ */
+bool a_string_bytes_ends_with(const char* data, size_t len,
+                              const char* suffix, size_t suffix_len);
+
+/**
+ * enables the buffer cache for the calling thread.
+ *
+ * while it is enabled, buffers freed by `a_string_free` or released by
+ * `a_string_reserve` are kept on per-thread free lists, one per power of 2
+ * size, and new buffers are taken from those lists before asking malloc.
+ * Capacities are rounded up to their size class, so `cap` may be larger than
+ * requested. Buffers stay ordinary malloc'd memory either way, and may be
+ * freed on any thread.
+ *
+ * the cached buffers are released when the thread exits.
+ *
+ * @param config the limits, or NULL for the defaults (64 KiB buffers, 64 per
+ *               class, 4 MiB in total)
+ */
+void a_string_cache_enable(const a_string_cache_config* config);
+
+/**
+ * frees every cached buffer of the calling thread and disables its cache.
+ */
+void a_string_cache_disable(void);
+
+/**
+ * frees cached buffers of the calling thread, largest first, until at most
+ * a number of bytes remain cached. The cache stays enabled.
+ *
+ * @param keep_bytes how many bytes may stay cached
+ */
+void a_string_cache_trim(size_t keep_bytes);
+
+/**
+ * gets the counters of the calling thread's buffer cache.
+ */
+a_string_cache_stats a_string_cache_get_stats(void);
+
 #endif // _A_STRING_H
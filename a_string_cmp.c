@@ -0,0 +1,259 @@
+/*
+ * a_string/a_vector: a scuffed dynamic vector/string implementation.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+#if defined(__x86_64__)
+#define A_CMP_X86
+#include <immintrin.h>
+#endif
+
+static inline u64 load_u64(const char* p) {
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline u32 load_u32(const char* p) {
+    u32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// index of the first differing byte, given the xor of 2 nonzero words.
+static inline size_t first_diff(u64 x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (size_t)__builtin_clzll(x) / 8;
+#else
+    return (size_t)__builtin_ctzll(x) / 8;
+#endif
+}
+
+static inline size_t first_diff32(u32 x) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (size_t)__builtin_clz(x) / 8;
+#else
+    return (size_t)__builtin_ctz(x) / 8;
+#endif
+}
+
+/*
+ * mismatch of fewer than 16 bytes. The first and last 8 (or 4) bytes are
+ * compared with overlapping loads, so there is no byte loop.
+ */
+static inline size_t mismatch_short(const char* a, const char* b, size_t n) {
+    if (n >= 8) {
+        u64 x = load_u64(a) ^ load_u64(b);
+        if (x)
+            return first_diff(x);
+        x = load_u64(a + n - 8) ^ load_u64(b + n - 8);
+        return x ? n - 8 + first_diff(x) : n;
+    }
+    if (n >= 4) {
+        u32 x = load_u32(a) ^ load_u32(b);
+        if (x)
+            return first_diff32(x);
+        x = load_u32(a + n - 4) ^ load_u32(b + n - 4);
+        return x ? n - 4 + first_diff32(x) : n;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i])
+            return i;
+    }
+    return n;
+}
+
+#ifdef A_CMP_X86
+
+// bitmask of the equal bytes of the 16 bytes at a and b.
+static inline u32 eq_mask16(const char* a, const char* b) {
+    __m128i va = _mm_loadu_si128((const __m128i*)a);
+    __m128i vb = _mm_loadu_si128((const __m128i*)b);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+}
+
+/*
+ * mismatch of at least 16 bytes with SSE2, which is part of the x86-64
+ * baseline: 64 bytes per step, then 16, then the last 16 bytes overlapping
+ * what was already compared.
+ */
+static size_t mismatch_sse2(const char* a, const char* b, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&a[i]),
+                                    _mm_loadu_si128((const __m128i*)&b[i]));
+        __m128i e1 =
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&a[i + 16]),
+                           _mm_loadu_si128((const __m128i*)&b[i + 16]));
+        __m128i e2 =
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&a[i + 32]),
+                           _mm_loadu_si128((const __m128i*)&b[i + 32]));
+        __m128i e3 =
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&a[i + 48]),
+                           _mm_loadu_si128((const __m128i*)&b[i + 48]));
+        __m128i all = _mm_and_si128(_mm_and_si128(e0, e1),
+                                    _mm_and_si128(e2, e3));
+        if (_mm_movemask_epi8(all) != 0xFFFF) {
+            u64 eq = (u64)(u32)_mm_movemask_epi8(e0) |
+                     ((u64)(u32)_mm_movemask_epi8(e1) << 16) |
+                     ((u64)(u32)_mm_movemask_epi8(e2) << 32) |
+                     ((u64)(u32)_mm_movemask_epi8(e3) << 48);
+            return i + (size_t)__builtin_ctzll(~eq);
+        }
+    }
+    for (; i + 16 <= n; i += 16) {
+        u32 eq = eq_mask16(&a[i], &b[i]);
+        if (eq != 0xFFFF)
+            return i + (size_t)__builtin_ctz(~eq);
+    }
+    if (i < n) {
+        i = n - 16;
+        u32 eq = eq_mask16(&a[i], &b[i]);
+        if (eq != 0xFFFF)
+            return i + (size_t)__builtin_ctz(~eq);
+    }
+    return n;
+}
+
+// like mismatch_sse2, with 32 byte vectors.
+__attribute__((target("avx2"))) static size_t
+mismatch_avx2(const char* a, const char* b, size_t n) {
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i e0 =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&a[i]),
+                              _mm256_loadu_si256((const __m256i*)&b[i]));
+        __m256i e1 =
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&a[i + 32]),
+                              _mm256_loadu_si256((const __m256i*)&b[i + 32]));
+        if ((u32)_mm256_movemask_epi8(_mm256_and_si256(e0, e1)) !=
+            0xFFFFFFFF) {
+            u64 eq = (u64)(u32)_mm256_movemask_epi8(e0) |
+                     ((u64)(u32)_mm256_movemask_epi8(e1) << 32);
+            return i + (size_t)__builtin_ctzll(~eq);
+        }
+    }
+    if (i + 32 <= n) {
+        u32 eq = (u32)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&a[i]),
+                              _mm256_loadu_si256((const __m256i*)&b[i])));
+        if (eq != 0xFFFFFFFF)
+            return i + (size_t)__builtin_ctz(~eq);
+        i += 32;
+    }
+    for (; i + 16 <= n; i += 16) {
+        u32 eq = eq_mask16(&a[i], &b[i]);
+        if (eq != 0xFFFF)
+            return i + (size_t)__builtin_ctz(~eq);
+    }
+    if (i < n) {
+        i = n - 16;
+        u32 eq = eq_mask16(&a[i], &b[i]);
+        if (eq != 0xFFFF)
+            return i + (size_t)__builtin_ctz(~eq);
+    }
+    return n;
+}
+
+#endif // A_CMP_X86
+
+static inline size_t mismatch(const char* lhs, const char* rhs, size_t len) {
+    if (len < 16)
+        return mismatch_short(lhs, rhs, len);
+
+#ifdef A_CMP_X86
+    // below 64 bytes the wider vectors save nothing.
+    if (len >= 64 && __builtin_cpu_supports("avx2"))
+        return mismatch_avx2(lhs, rhs, len);
+    return mismatch_sse2(lhs, rhs, len);
+#else
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        u64 x = load_u64(&lhs[i]) ^ load_u64(&rhs[i]);
+        if (x)
+            return i + first_diff(x);
+    }
+    return i + mismatch_short(&lhs[i], &rhs[i], len - i);
+#endif
+}
+
+size_t a_string_bytes_mismatch(const char* lhs, const char* rhs, size_t len) {
+    return mismatch(lhs, rhs, len);
+}
+
+size_t a_string_bytes_common_prefix(const char* lhs, size_t lhs_len,
+                                    const char* rhs, size_t rhs_len) {
+    return mismatch(lhs, rhs, (lhs_len < rhs_len) ? lhs_len : rhs_len);
+}
+
+bool a_string_bytes_equal(const char* lhs, size_t lhs_len, const char* rhs,
+                          size_t rhs_len) {
+    return lhs_len == rhs_len && mismatch(lhs, rhs, lhs_len) == lhs_len;
+}
+
+int a_string_bytes_compare(const char* lhs, size_t lhs_len, const char* rhs,
+                           size_t rhs_len) {
+    size_t len = (lhs_len < rhs_len) ? lhs_len : rhs_len;
+    size_t i = mismatch(lhs, rhs, len);
+    if (i < len)
+        return ((u8)lhs[i] < (u8)rhs[i]) ? -1 : 1;
+    return (lhs_len > rhs_len) - (lhs_len < rhs_len);
+}
+
+bool a_string_bytes_starts_with(const char* data, size_t len,
+                                const char* prefix, size_t prefix_len) {
+    return prefix_len <= len &&
+           mismatch(data, prefix, prefix_len) == prefix_len;
+}
+
+bool a_string_bytes_ends_with(const char* data, size_t len,
+                              const char* suffix, size_t suffix_len) {
+    return suffix_len <= len &&
+           mismatch(&data[len - suffix_len], suffix, suffix_len) == suffix_len;
+}
+
+int a_string_compare(const a_string* lhs, const a_string* rhs) {
+    if (!a_string_valid(lhs))
+        panic("cannot compare an invalid a_string!");
+
+    if (!a_string_valid(rhs))
+        panic("cannot compare an invalid a_string!");
+
+    return a_string_bytes_compare(lhs->data, lhs->len, rhs->data, rhs->len);
+}
+
+size_t a_string_common_prefix(const a_string* lhs, const a_string* rhs) {
+    if (!a_string_valid(lhs))
+        panic("cannot compare an invalid a_string!");
+
+    if (!a_string_valid(rhs))
+        panic("cannot compare an invalid a_string!");
+
+    return a_string_bytes_common_prefix(lhs->data, lhs->len, rhs->data,
+                                        rhs->len);
+}
+
+bool a_string_starts_with(const a_string* s, a_string_view prefix) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    return a_string_bytes_starts_with(s->data, s->len, prefix.data,
+                                      prefix.len);
+}
+
+bool a_string_ends_with(const a_string* s, a_string_view suffix) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    return a_string_bytes_ends_with(s->data, s->len, suffix.data, suffix.len);
+}
@@ -0,0 +1,506 @@
+/*
+ * a_string/a_vector: a scuffed dynamic vector/string implementation.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+#if defined(__linux__) && !defined(A_STRING_NO_IO_URING)
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define A_STRING_IO_URING
+#endif
+#endif
+
+// chunk size used when a file does not report its size (e.g. procfs).
+#define READ_CHUNK 4096
+
+// upper bound on the number of worker threads in the fallback path.
+#define MAX_WORKERS 16
+
+// reads a whole file with plain syscalls. returns 0 or an errno value.
+static int read_one(const char* path, a_string* out) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return errno;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+
+    size_t cap = (st.st_size > 0) ? (size_t)st.st_size + 1 : READ_CHUNK;
+    a_string res = a_string_with_capacity(cap);
+    if (!a_string_valid(&res)) {
+        close(fd);
+        return ENOMEM;
+    }
+
+    for (;;) {
+        if (res.len + 1 == res.cap) {
+            if (st.st_size > 0)
+                break; // got everything fstat promised
+            a_string_reserve(&res, res.cap * 2);
+        }
+
+        ssize_t n = read(fd, &res.data[res.len], res.cap - res.len - 1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            int err = errno;
+            close(fd);
+            a_string_free(&res);
+            return err;
+        }
+        if (n == 0)
+            break;
+        res.len += (size_t)n;
+    }
+
+    close(fd);
+    res.data[res.len] = '\0';
+    *out = res;
+    return 0;
+}
+
+typedef struct {
+    const char* const* paths;
+    a_string* out;
+    int* errs;
+    size_t n;
+    _Atomic(size_t) next;
+} pool_job;
+
+static void* pool_worker(void* arg) {
+    pool_job* job = arg;
+    for (;;) {
+        size_t i =
+            atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+        if (i >= job->n)
+            break;
+        job->errs[i] = read_one(job->paths[i], &job->out[i]);
+    }
+    return NULL;
+}
+
+static void read_files_pool(const char* const* paths, size_t n, a_string* out,
+                            int* errs) {
+    pool_job job = {.paths = paths, .out = out, .errs = errs, .n = n};
+    atomic_init(&job.next, 0);
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nworkers = (ncpu > 0) ? (size_t)ncpu : 1;
+    // file reads mostly block, so oversubscribe a little.
+    nworkers *= 2;
+    if (nworkers > MAX_WORKERS)
+        nworkers = MAX_WORKERS;
+    if (nworkers > n)
+        nworkers = n;
+    if (nworkers == 0)
+        nworkers = 1;
+
+    pthread_t threads[MAX_WORKERS];
+    size_t started = 0;
+    for (; started < nworkers - 1; started++) {
+        if (pthread_create(&threads[started], NULL, pool_worker, &job) != 0)
+            break;
+    }
+
+    // the calling thread pitches in, so this works even without threads.
+    pool_worker(&job);
+
+    for (size_t i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+}
+
+#ifdef A_STRING_IO_URING
+
+/*
+ * io_uring path. Every file goes through openat + statx (submitted together,
+ * both by path), then one or more reads, then close. Up to RING_ENTRIES
+ * operations are in flight at once.
+ */
+
+#define RING_ENTRIES 256
+
+enum { OP_OPEN, OP_STATX, OP_READ, OP_CLOSE };
+
+typedef struct {
+    int fd;
+    int err;
+    int pending; // open/statx completions still outstanding
+    bool done;
+    struct statx stx;
+} uring_file;
+
+typedef struct {
+    int fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned* sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    size_t sqes_size;
+
+    unsigned sq_tail_local; // not yet published to the kernel
+    unsigned to_submit;
+    unsigned inflight;
+} uring;
+
+static bool uring_init(uring* r) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(r, 0, sizeof(*r));
+
+    int fd = (int)syscall(__NR_io_uring_setup, RING_ENTRIES, &p);
+    if (fd < 0)
+        return false;
+
+    // openat/statx/read/close all arrived in 5.6, alongside this flag.
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        close(fd);
+        return false;
+    }
+
+    r->fd = fd;
+    r->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) {
+        if (r->cq_size > r->sq_size)
+            r->sq_size = r->cq_size;
+        r->cq_size = r->sq_size;
+    }
+
+    r->sq_ptr = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (r->sq_ptr == MAP_FAILED)
+        goto fail;
+
+    if (single) {
+        r->cq_ptr = r->sq_ptr;
+    } else {
+        r->cq_ptr = mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (r->cq_ptr == MAP_FAILED)
+            goto fail_sq;
+    }
+
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED)
+        goto fail_cq;
+
+    char* sq = r->sq_ptr;
+    char* cq = r->cq_ptr;
+    r->sq_head = (unsigned*)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    r->sq_tail_local = *r->sq_tail;
+    return true;
+
+fail_cq:
+    if (!single)
+        munmap(r->cq_ptr, r->cq_size);
+fail_sq:
+    munmap(r->sq_ptr, r->sq_size);
+fail:
+    close(fd);
+    return false;
+}
+
+static void uring_free(uring* r) {
+    munmap(r->sqes, r->sqes_size);
+    if (r->cq_ptr != r->sq_ptr)
+        munmap(r->cq_ptr, r->cq_size);
+    munmap(r->sq_ptr, r->sq_size);
+    close(r->fd);
+}
+
+// callers make sure fewer than RING_ENTRIES operations are in flight.
+static struct io_uring_sqe* uring_sqe(uring* r, u8 op, size_t idx) {
+    unsigned i = r->sq_tail_local++ & r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[i];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = op;
+    sqe->user_data = ((u64)idx << 2);
+    r->sq_array[i] = i;
+    r->to_submit++;
+    r->inflight++;
+    return sqe;
+}
+
+static void uring_open_statx(uring* r, size_t idx, const char* path,
+                             uring_file* f) {
+    struct io_uring_sqe* sqe = uring_sqe(r, IORING_OP_OPENAT, idx);
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (u64)(uintptr_t)path;
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    sqe->user_data |= OP_OPEN;
+
+    sqe = uring_sqe(r, IORING_OP_STATX, idx);
+    sqe->fd = AT_FDCWD;
+    sqe->addr = (u64)(uintptr_t)path;
+    sqe->len = STATX_SIZE;
+    sqe->off = (u64)(uintptr_t)&f->stx;
+    sqe->user_data |= OP_STATX;
+
+    f->pending = 2;
+}
+
+static void uring_read(uring* r, size_t idx, uring_file* f, a_string* buf) {
+    struct io_uring_sqe* sqe = uring_sqe(r, IORING_OP_READ, idx);
+    sqe->fd = f->fd;
+    sqe->addr = (u64)(uintptr_t)&buf->data[buf->len];
+    size_t want = buf->cap - buf->len - 1;
+    sqe->len = (u32)(want > (1u << 30) ? (1u << 30) : want);
+    sqe->off = buf->len;
+    sqe->user_data |= OP_READ;
+}
+
+static void uring_close(uring* r, size_t idx, uring_file* f) {
+    struct io_uring_sqe* sqe = uring_sqe(r, IORING_OP_CLOSE, idx);
+    sqe->fd = f->fd;
+    sqe->user_data |= OP_CLOSE;
+}
+
+// handles one completion, possibly queueing the next step for the file.
+// returns true once the file is finished with.
+static bool uring_complete(uring* r, size_t idx, u8 op, i32 res,
+                           uring_file* f, a_string* buf) {
+    switch (op) {
+    case OP_OPEN:
+    case OP_STATX:
+        if (op == OP_OPEN)
+            f->fd = res;
+        if (res < 0 && f->err == 0)
+            f->err = -res;
+        if (--f->pending > 0)
+            return false;
+
+        if (f->err != 0) {
+            if (f->fd < 0)
+                return true;
+            uring_close(r, idx, f);
+            return false;
+        }
+
+        // statx reports 0 for files like those in procfs; read those in
+        // chunks until EOF.
+        *buf = a_string_with_capacity(
+            f->stx.stx_size > 0 ? f->stx.stx_size + 1 : READ_CHUNK);
+        if (!a_string_valid(buf)) {
+            f->err = ENOMEM;
+            uring_close(r, idx, f);
+            return false;
+        }
+        uring_read(r, idx, f, buf);
+        return false;
+
+    case OP_READ:
+        if (res < 0) {
+            f->err = -res;
+            a_string_free(buf);
+            uring_close(r, idx, f);
+            return false;
+        }
+        buf->len += (size_t)res;
+        if (res > 0) {
+            if (buf->len + 1 < buf->cap) {
+                uring_read(r, idx, f, buf);
+                return false;
+            }
+            if (f->stx.stx_size == 0) {
+                a_string_reserve(buf, buf->cap * 2);
+                uring_read(r, idx, f, buf);
+                return false;
+            }
+        }
+        buf->data[buf->len] = '\0';
+        uring_close(r, idx, f);
+        return false;
+
+    case OP_CLOSE:
+        f->fd = -1;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * hands the files the ring did not finish to the thread pool, once
+ * io_uring_enter fails for good. Returns false if the kernel may still
+ * complete operations, whose buffers and fds are then left to it rather
+ * than freed.
+ */
+static bool uring_fallback(uring* r, const char* const* paths, size_t n,
+                           a_string* out, int* errs, uring_file* files,
+                           size_t next) {
+    bool quiet = r->inflight == r->to_submit; // nothing reached the kernel
+
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++)
+        m += !files[i].done;
+
+    const char** sub_paths = malloc(m * sizeof(char*));
+    check_alloc(sub_paths);
+    a_string* sub_out = malloc(m * sizeof(a_string));
+    check_alloc(sub_out);
+    int* sub_errs = calloc(m, sizeof(int));
+    check_alloc(sub_errs);
+
+    size_t j = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (files[i].done)
+            continue;
+        if (i < next && quiet) {
+            if (files[i].fd >= 0)
+                close(files[i].fd);
+            a_string_free(&out[i]);
+        }
+        out[i] = a_string_new_invalid();
+        sub_paths[j] = paths[i];
+        sub_out[j] = a_string_new_invalid();
+        j++;
+    }
+
+    read_files_pool(sub_paths, m, sub_out, sub_errs);
+
+    j = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (files[i].done)
+            continue;
+        out[i] = sub_out[j];
+        errs[i] = sub_errs[j];
+        j++;
+    }
+
+    free(sub_paths);
+    free(sub_out);
+    free(sub_errs);
+    return quiet;
+}
+
+static bool read_files_uring(const char* const* paths, size_t n, a_string* out,
+                             int* errs) {
+    uring r;
+    if (!uring_init(&r))
+        return false;
+
+    uring_file* files = calloc(n, sizeof(uring_file));
+    check_alloc(files);
+
+    size_t next = 0;
+    size_t closed = 0;
+    while (closed < n) {
+        // every new file takes two slots, and each completion frees the slot
+        // that its follow-up operation needs.
+        while (next < n && r.inflight + 2 <= RING_ENTRIES) {
+            files[next].fd = -1;
+            uring_open_statx(&r, next, paths[next], &files[next]);
+            next++;
+        }
+
+        __atomic_store_n(r.sq_tail, r.sq_tail_local, __ATOMIC_RELEASE);
+        int ret = (int)syscall(__NR_io_uring_enter, r.fd, r.to_submit, 1,
+                               IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+            // e.g. ENOMEM, or EPERM from a seccomp policy.
+            if (uring_fallback(&r, paths, n, out, errs, files, next))
+                free(files); // else statx may still write to it
+            uring_free(&r);
+            return true;
+        }
+        r.to_submit -= (unsigned)ret;
+
+        unsigned head = *r.cq_head;
+        unsigned tail = __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct io_uring_cqe* cqe = &r.cqes[head & r.cq_mask];
+            size_t idx = (size_t)(cqe->user_data >> 2);
+            u8 op = (u8)(cqe->user_data & 3);
+            uring_file* f = &files[idx];
+            r.inflight--;
+
+            if (uring_complete(&r, idx, op, cqe->res, f, &out[idx])) {
+                f->done = true;
+                errs[idx] = f->err;
+                closed++;
+            }
+        }
+        __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    free(files);
+    uring_free(&r);
+    return true;
+}
+
+#endif // A_STRING_IO_URING
+
+a_vector_a_string a_string_read_files(const char* const* paths, size_t n,
+                                      int* errs) {
+    if (paths == NULL && n != 0)
+        panic("list of paths is null!");
+
+    a_vector_a_string res = a_vector_a_string_with_capacity(n ? n : 1);
+    if (n == 0)
+        return res;
+
+    for (size_t i = 0; i < n; i++)
+        res.data[i] = a_string_new_invalid();
+    res.len = n;
+
+    int* errbuf = errs;
+    if (errbuf == NULL) {
+        errbuf = calloc(n, sizeof(int));
+        check_alloc(errbuf);
+    }
+
+#ifdef A_STRING_IO_URING
+    if (!read_files_uring(paths, n, res.data, errbuf))
+#endif
+        read_files_pool(paths, n, res.data, errbuf);
+
+    if (errbuf != errs)
+        free(errbuf);
+    return res;
+}
@@ -0,0 +1,454 @@
+/*
+ * a_string/a_vector: a scuffed dynamic vector/string implementation.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <string.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+#if defined(__x86_64__)
+#define A_UTF8_X86
+#include <immintrin.h>
+#endif
+
+static inline u64 load_u64(const char* p) {
+    u64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+ * scalar validation, following table 3-7 of the Unicode standard. Used on
+ * targets without SSSE3.
+ */
+static bool utf8_valid_scalar(const u8* p, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        // skip ASCII eight bytes at a time.
+        while (i + 8 <= len &&
+               (load_u64((const char*)&p[i]) & 0x8080808080808080ULL) == 0)
+            i += 8;
+        if (i >= len)
+            break;
+
+        u8 c = p[i];
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t n;
+        u8 lo = 0x80, hi = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) {
+            n = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            n = 2;
+            if (c == 0xE0)
+                lo = 0xA0; // overlong
+            else if (c == 0xED)
+                hi = 0x9F; // surrogates
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            n = 3;
+            if (c == 0xF0)
+                lo = 0x90; // overlong
+            else if (c == 0xF4)
+                hi = 0x8F; // > U+10FFFF
+        } else {
+            return false;
+        }
+
+        if (n >= len - i)
+            return false; // truncated
+        if (p[i + 1] < lo || p[i + 1] > hi)
+            return false;
+        for (size_t j = 2; j <= n; j++) {
+            if ((p[i + j] & 0xC0) != 0x80)
+                return false;
+        }
+        i += n + 1;
+    }
+    return true;
+}
+
+#ifdef A_UTF8_X86
+
+/*
+ * SIMD validation, after John Keiser and Daniel Lemire, "Validating UTF-8 In
+ * Less Than One Instruction Per Byte" (2021). Each byte is classified by
+ * three nibble lookups against the byte before it, which catches every error
+ * except missing 3rd/4th continuation bytes; those are checked separately.
+ */
+
+#define TOO_SHORT      (1 << 0)
+#define TOO_LONG       (1 << 1)
+#define OVERLONG_3     (1 << 2)
+#define TOO_LARGE      (1 << 3)
+#define SURROGATE      (1 << 4)
+#define OVERLONG_2     (1 << 5)
+#define TOO_LARGE_1000 (1 << 6)
+#define OVERLONG_4     (1 << 6)
+#define TWO_CONTS      (1 << 7)
+#define CARRY          (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+__attribute__((target("ssse3"))) static inline __m128i
+utf8_check_block(__m128i input, __m128i prev_input) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i byte_1_high_tbl = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m128i byte_1_low_tbl = _mm_setr_epi8(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY,
+        CARRY, CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m128i byte_2_high_tbl = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 |
+            OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(
+        byte_1_high_tbl, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte_1_low =
+        _mm_shuffle_epi8(byte_1_low_tbl, _mm_and_si128(prev1, nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(
+        byte_2_high_tbl, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special =
+        _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // the 3rd and 4th bytes of a sequence must be continuations.
+    __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth),
+                                   _mm_set1_epi8((char)0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+// nonzero where the block ends in the middle of a multi-byte sequence.
+__attribute__((target("ssse3"))) static inline __m128i
+utf8_incomplete(__m128i input) {
+    const __m128i max = _mm_setr_epi8(
+        (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF,
+        (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF,
+        (char)0xFF, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm_subs_epu8(input, max);
+}
+
+__attribute__((target("ssse3"))) static inline bool
+utf8_has_error(__m128i error) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) !=
+           0xFFFF;
+}
+
+__attribute__((target("ssse3"))) static bool utf8_valid_ssse3(const u8* p,
+                                                              size_t len) {
+    __m128i error = _mm_setzero_si128();
+    __m128i prev_input = _mm_setzero_si128();
+    __m128i prev_incomplete = _mm_setzero_si128();
+    size_t i = 0;
+
+    while (i < len) {
+        // the ASCII fast path runs four blocks at a time.
+        while (i + 64 <= len) {
+            __m128i a = _mm_loadu_si128((const __m128i*)&p[i]);
+            __m128i b = _mm_loadu_si128((const __m128i*)&p[i + 16]);
+            __m128i c = _mm_loadu_si128((const __m128i*)&p[i + 32]);
+            __m128i d = _mm_loadu_si128((const __m128i*)&p[i + 48]);
+            __m128i any =
+                _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            if (_mm_movemask_epi8(any) != 0)
+                break;
+            error = _mm_or_si128(error, prev_incomplete);
+            prev_incomplete = _mm_setzero_si128();
+            prev_input = d;
+            i += 64;
+        }
+
+        __m128i input;
+        if (i + 16 <= len) {
+            input = _mm_loadu_si128((const __m128i*)&p[i]);
+        } else if (i < len) {
+            // pad the tail with ASCII, which also flags truncated sequences.
+            u8 tail[16] = {0};
+            memcpy(tail, &p[i], len - i);
+            input = _mm_loadu_si128((const __m128i*)tail);
+        } else {
+            break;
+        }
+
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prev_incomplete);
+            prev_incomplete = _mm_setzero_si128();
+        } else {
+            error = _mm_or_si128(error, utf8_check_block(input, prev_input));
+            prev_incomplete = utf8_incomplete(input);
+        }
+        prev_input = input;
+        i += 16;
+
+        // bail out early on bad input, but not often enough to cost anything.
+        if ((i & 0x3FF) == 0 && utf8_has_error(error))
+            return false;
+    }
+
+    return !utf8_has_error(_mm_or_si128(error, prev_incomplete));
+}
+
+#endif // A_UTF8_X86
+
+bool a_string_utf8_valid(const char* data, size_t len) {
+#ifdef A_UTF8_X86
+    if (__builtin_cpu_supports("ssse3"))
+        return utf8_valid_ssse3((const u8*)data, len);
+#endif
+    return utf8_valid_scalar((const u8*)data, len);
+}
+
+size_t a_string_utf8_count(const char* data, size_t len) {
+    // every byte that is not a continuation byte (10xxxxxx) starts a
+    // codepoint.
+    const u8* p = (const u8*)data;
+    size_t conts = 0;
+    size_t i = 0;
+
+#ifdef A_UTF8_X86
+    // SSE2 is part of the x86-64 baseline. Per-byte counters are summed for
+    // at most 255 rounds before they are widened, so they cannot overflow.
+    const __m128i first_lead = _mm_set1_epi8((char)0xC0);
+    while (i + 16 <= len) {
+        __m128i acc = _mm_setzero_si128();
+        size_t rounds = (len - i) / 16;
+        if (rounds > 255)
+            rounds = 255;
+        for (size_t r = 0; r < rounds; r++, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)&p[i]);
+            // signed compare: continuation bytes are -128 ... -65.
+            __m128i is_cont = _mm_cmplt_epi8(v, first_lead);
+            acc = _mm_sub_epi8(acc, is_cont);
+        }
+        __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+        conts += (size_t)_mm_cvtsi128_si64(sums) +
+                 (size_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+    }
+#else
+    while (i + 8 <= len) {
+        u64 v = load_u64((const char*)&p[i]);
+        conts += (size_t)__builtin_popcountll(v & ~(v << 1) &
+                                             0x8080808080808080ULL);
+        i += 8;
+    }
+#endif
+
+    for (; i < len; i++)
+        conts += (p[i] & 0xC0) == 0x80;
+
+    return len - conts;
+}
+
+// decodes one codepoint at p, storing its length in *n. Invalid sequences
+// decode to 0x80000000 | byte with a length of 1.
+static inline u32 utf8_decode(const u8* p, size_t avail, size_t* n) {
+    u8 c = p[0];
+    if (c < 0x80) {
+        *n = 1;
+        return c;
+    }
+
+    u32 cp;
+    size_t len;
+    u32 min;
+    if (c >= 0xC2 && c <= 0xDF) {
+        len = 2;
+        cp = c & 0x1F;
+        min = 0x80;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        len = 3;
+        cp = c & 0x0F;
+        min = 0x800;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        len = 4;
+        cp = c & 0x07;
+        min = 0x10000;
+    } else {
+        goto invalid;
+    }
+
+    if (len > avail)
+        goto invalid;
+    for (size_t j = 1; j < len; j++) {
+        if ((p[j] & 0xC0) != 0x80)
+            goto invalid;
+        cp = (cp << 6) | (p[j] & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+        goto invalid;
+
+    *n = len;
+    return cp;
+
+invalid:
+    *n = 1;
+    return 0x80000000u | c;
+}
+
+a_string_utf8_iter a_string_utf8_iter_new(const char* data, size_t len) {
+    return (a_string_utf8_iter){.data = data, .len = len, .pos = 0};
+}
+
+bool a_string_utf8_next(a_string_utf8_iter* it, u32* cp) {
+    if (it->pos >= it->len)
+        return false;
+
+    const u8* p = (const u8*)&it->data[it->pos];
+    if (p[0] < 0x80) {
+        *cp = p[0];
+        it->pos++;
+        return true;
+    }
+
+    size_t n;
+    u32 c = utf8_decode(p, it->len - it->pos, &n);
+    *cp = (c & 0x80000000u) ? 0xFFFD : c;
+    it->pos += n;
+    return true;
+}
+
+u32 a_string_utf8_fold(u32 cp) {
+    if (cp < 0x80)
+        return (cp - 'A' < 26) ? cp + 32 : cp;
+
+    if (cp < 0x100) {
+        if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7)
+            return cp + 32;
+        if (cp == 0xB5) // micro sign
+            return 0x3BC;
+        return cp;
+    }
+
+    if (cp < 0x180) {
+        // latin extended-A is mostly upper/lower pairs.
+        if (cp == 0x130 || cp == 0x131 || cp == 0x138 || cp == 0x149)
+            return cp;
+        if (cp == 0x178)
+            return 0xFF;
+        if (cp == 0x17F) // long s
+            return 's';
+        if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E))
+            return (cp & 1) ? cp + 1 : cp;
+        return (cp & 1) ? cp : cp + 1;
+    }
+
+    if (cp >= 0x370 && cp < 0x400) {
+        if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2)
+            return cp + 32;
+        if (cp == 0x386)
+            return 0x3AC;
+        if (cp >= 0x388 && cp <= 0x38A)
+            return cp + 37;
+        if (cp == 0x38C)
+            return 0x3CC;
+        if (cp == 0x38E || cp == 0x38F)
+            return cp + 63;
+        if (cp == 0x3C2) // final sigma
+            return 0x3C3;
+        return cp;
+    }
+
+    if (cp >= 0x400 && cp < 0x530) {
+        if (cp < 0x410)
+            return cp + 80;
+        if (cp < 0x430)
+            return cp + 32;
+        if (cp == 0x4C0)
+            return 0x4CF;
+        if (cp >= 0x4C1 && cp <= 0x4CE)
+            return (cp & 1) ? cp + 1 : cp;
+        if ((cp >= 0x460 && cp <= 0x481) || (cp >= 0x48A && cp <= 0x4BF) ||
+            cp >= 0x4D0)
+            return (cp & 1) ? cp : cp + 1;
+        return cp;
+    }
+
+    if (cp >= 0x531 && cp <= 0x556) // armenian
+        return cp + 48;
+    if (cp >= 0x10A0 && cp <= 0x10C5) // georgian
+        return cp + 0x1C60;
+    if ((cp >= 0x1E00 && cp <= 0x1E95) || (cp >= 0x1EA0 && cp <= 0x1EFF))
+        return (cp & 1) ? cp : cp + 1;
+    if (cp == 0x1E9E) // capital sharp s
+        return 0xDF;
+    if (cp >= 0x2160 && cp <= 0x216F) // roman numerals
+        return cp + 16;
+    if (cp >= 0x24B6 && cp <= 0x24CF) // circled letters
+        return cp + 26;
+    if (cp >= 0x2C00 && cp <= 0x2C2F) // glagolitic
+        return cp + 48;
+    if (cp >= 0xFF21 && cp <= 0xFF3A) // fullwidth latin
+        return cp + 32;
+    if (cp >= 0x10400 && cp <= 0x10427) // deseret
+        return cp + 40;
+    return cp;
+}
+
+// lowercases eight ASCII bytes at once.
+static inline u64 ascii_lower8(u64 v) {
+    u64 ge_a = v + 0x3F3F3F3F3F3F3F3FULL; // high bit set if >= 'A'
+    u64 gt_z = v + 0x2525252525252525ULL; // high bit set if > 'Z'
+    u64 is_upper = (ge_a ^ gt_z) & 0x8080808080808080ULL;
+    return v | (is_upper >> 2);
+}
+
+bool a_string_utf8_equal_fold(const char* lhs, size_t lhs_len,
+                              const char* rhs, size_t rhs_len) {
+    const u8* a = (const u8*)lhs;
+    const u8* b = (const u8*)rhs;
+    size_t i = 0, j = 0;
+
+    while (i < lhs_len && j < rhs_len) {
+        // ASCII fast path: while both sides are plain ASCII, they can only
+        // match byte for byte.
+        while (i + 8 <= lhs_len && j + 8 <= rhs_len) {
+            u64 x = load_u64((const char*)&a[i]);
+            u64 y = load_u64((const char*)&b[j]);
+            if ((x | y) & 0x8080808080808080ULL)
+                break;
+            if (x != y && ascii_lower8(x) != ascii_lower8(y))
+                return false;
+            i += 8;
+            j += 8;
+        }
+        if (i >= lhs_len || j >= rhs_len)
+            break;
+
+        size_t n, m;
+        u32 ca = utf8_decode(&a[i], lhs_len - i, &n);
+        u32 cb = utf8_decode(&b[j], rhs_len - j, &m);
+        if (ca != cb && a_string_utf8_fold(ca) != a_string_utf8_fold(cb))
+            return false;
+        i += n;
+        j += m;
+    }
+
+    return i == lhs_len && j == rhs_len;
+}
@@ -0,0 +1,323 @@
+/*
+ * a_strsort: fast lexicographic sorting of string collections.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_strsort.h"
+
+// buckets at most this big are insertion sorted.
+#define INSERTION_MAX 16
+
+// inputs smaller than this are never sorted on several threads.
+#define PARALLEL_MIN (1 << 16)
+
+// upper bound on the number of sorting threads.
+#define MAX_THREADS 64
+
+/*
+ * a string being sorted. `key` caches the 8 bytes at the current depth,
+ * big endian and zero padded, so comparing keys compares bytes.
+ */
+typedef struct {
+    u64 key;
+    const char* data;
+    size_t len;
+    size_t idx;
+} sort_item;
+
+static inline u64 load_key(const char* data, size_t len, size_t depth) {
+    u64 key = 0;
+    if (depth >= len)
+        return 0;
+
+    size_t left = len - depth;
+    if (left >= 8) {
+        memcpy(&key, &data[depth], 8);
+    } else {
+        u8 buf[8] = {0};
+        memcpy(buf, &data[depth], left);
+        memcpy(&key, buf, 8);
+    }
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    key = __builtin_bswap64(key);
+#endif
+    return key;
+}
+
+// compares two strings whose first `depth` bytes are equal.
+static inline int cmp_from(const sort_item* a, const sort_item* b,
+                           size_t depth) {
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+
+    // equal keys: compare what comes after them.
+    size_t d = depth + 8;
+    size_t alen = a->len > d ? a->len - d : 0;
+    size_t blen = b->len > d ? b->len - d : 0;
+    size_t n = alen < blen ? alen : blen;
+    if (n > 0) {
+        int c = memcmp(&a->data[d], &b->data[d], n);
+        if (c != 0)
+            return c;
+    }
+    return (a->len > b->len) - (a->len < b->len);
+}
+
+static void insertion_sort(sort_item* a, size_t n, size_t depth) {
+    for (size_t i = 1; i < n; i++) {
+        sort_item x = a[i];
+        size_t j = i;
+        while (j > 0 && cmp_from(&x, &a[j - 1], depth) < 0) {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = x;
+    }
+}
+
+static inline u64 median3(u64 a, u64 b, u64 c) {
+    if (a < b)
+        return b < c ? b : (a < c ? c : a);
+    return a < c ? a : (b < c ? c : b);
+}
+
+static void swap_items(sort_item* a, size_t i, size_t j) {
+    sort_item t = a[i];
+    a[i] = a[j];
+    a[j] = t;
+}
+
+/*
+ * multikey quicksort. All strings in `a` share their first `depth` bytes, and
+ * their keys hold the 8 bytes after that.
+ */
+static void mkqs(sort_item* a, size_t n, size_t depth) {
+    while (n > INSERTION_MAX) {
+        u64 pivot;
+        if (n > 256) {
+            size_t s = n / 8;
+            pivot = median3(median3(a[0].key, a[s].key, a[2 * s].key),
+                            median3(a[3 * s].key, a[4 * s].key, a[5 * s].key),
+                            median3(a[6 * s].key, a[7 * s].key, a[n - 1].key));
+        } else {
+            pivot = median3(a[0].key, a[n / 2].key, a[n - 1].key);
+        }
+
+        // a[0, lt) < pivot, a[lt, i) == pivot, a[gt, n) > pivot.
+        size_t lt = 0, i = 0, gt = n;
+        while (i < gt) {
+            u64 k = a[i].key;
+            if (k < pivot)
+                swap_items(a, lt++, i++);
+            else if (k > pivot)
+                swap_items(a, i, --gt);
+            else
+                i++;
+        }
+
+        mkqs(a, lt, depth);
+        mkqs(&a[gt], n - gt, depth);
+
+        // the equal strings that end within this key are done apart from
+        // their lengths, and sort before every longer one.
+        sort_item* eq = &a[lt];
+        size_t neq = gt - lt;
+        size_t nend = 0;
+        for (size_t j = 0; j < neq; j++) {
+            if (eq[j].len <= depth + 8)
+                swap_items(eq, nend++, j);
+        }
+        for (size_t j = 1; j < nend; j++) {
+            sort_item x = eq[j];
+            size_t k = j;
+            while (k > 0 && eq[k - 1].len > x.len) {
+                eq[k] = eq[k - 1];
+                k--;
+            }
+            eq[k] = x;
+        }
+
+        a = &eq[nend];
+        n = neq - nend;
+        depth += 8;
+        for (size_t j = 0; j < n; j++)
+            a[j].key = load_key(a[j].data, a[j].len, depth);
+    }
+    insertion_sort(a, n, depth);
+}
+
+typedef struct {
+    sort_item* items;
+    size_t depth;
+    size_t bounds[257];
+    _Atomic(size_t) next;
+} sort_job;
+
+static void* sort_buckets(void* arg) {
+    sort_job* job = arg;
+    for (;;) {
+        size_t b = atomic_fetch_add_explicit(&job->next, 1,
+                                             memory_order_relaxed);
+        if (b >= 256)
+            break;
+        size_t begin = job->bounds[b];
+        mkqs(&job->items[begin], job->bounds[b + 1] - begin, job->depth);
+    }
+    return NULL;
+}
+
+/*
+ * splits the items into 256 buckets with one counting pass, then sorts the
+ * buckets on several threads. Threads keep pulling the next unsorted bucket,
+ * so uneven buckets balance out.
+ *
+ * the buckets are picked by the first 8 bits in which the keys differ, not by
+ * the first byte, so that a prefix shared by every string does not put them
+ * all into the same bucket.
+ */
+static void sort_parallel(sort_item* items, size_t n, size_t nthreads) {
+    size_t depth = 0;
+    u64 diff = 0;
+    for (;;) {
+        bool ended = false;
+        for (size_t i = 0; i < n; i++) {
+            diff |= items[i].key ^ items[0].key;
+            ended |= items[i].len <= depth + 8;
+        }
+        if (diff != 0 || ended)
+            break;
+
+        depth += 8;
+        for (size_t i = 0; i < n; i++)
+            items[i].key = load_key(items[i].data, items[i].len, depth);
+    }
+    if (diff == 0) {
+        mkqs(items, n, depth);
+        return;
+    }
+
+    int top = 63 - __builtin_clzll(diff);
+    int shift = top >= 7 ? top - 7 : 0;
+
+    sort_item* tmp = malloc(n * sizeof(sort_item));
+    check_alloc(tmp);
+
+    size_t counts[256] = {0};
+    for (size_t i = 0; i < n; i++)
+        counts[(items[i].key >> shift) & 0xFF]++;
+
+    sort_job job = {.items = items, .depth = depth};
+    size_t pos = 0;
+    for (size_t b = 0; b < 256; b++) {
+        job.bounds[b] = pos;
+        pos += counts[b];
+    }
+    job.bounds[256] = n;
+
+    size_t fill[256];
+    memcpy(fill, job.bounds, sizeof(fill));
+    for (size_t i = 0; i < n; i++)
+        tmp[fill[(items[i].key >> shift) & 0xFF]++] = items[i];
+    memcpy(items, tmp, n * sizeof(sort_item));
+    free(tmp);
+
+    atomic_init(&job.next, 0);
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS] = {false};
+    for (size_t i = 1; i < nthreads; i++)
+        started[i] = pthread_create(&threads[i], NULL, sort_buckets, &job) == 0;
+    sort_buckets(&job);
+    for (size_t i = 1; i < nthreads; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+    }
+}
+
+static void sort_items(sort_item* items, size_t n, size_t nthreads) {
+    for (size_t i = 0; i < n; i++)
+        items[i].key = load_key(items[i].data, items[i].len, 0);
+
+    if (nthreads == 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (ncpu > 0) ? (size_t)ncpu : 1;
+    }
+    if (nthreads > MAX_THREADS)
+        nthreads = MAX_THREADS;
+
+    if (nthreads > 1 && n >= PARALLEL_MIN)
+        sort_parallel(items, n, nthreads);
+    else
+        mkqs(items, n, 0);
+}
+
+static sort_item* items_alloc(size_t n) {
+    sort_item* items = malloc((n ? n : 1) * sizeof(sort_item));
+    check_alloc(items);
+    return items;
+}
+
+void a_strsort_views(a_string_view* v, size_t n, size_t nthreads) {
+    if (v == NULL && n != 0)
+        panic("cannot sort a null array!");
+
+    sort_item* items = items_alloc(n);
+    for (size_t i = 0; i < n; i++)
+        items[i] = (sort_item){.data = v[i].data, .len = v[i].len, .idx = i};
+    sort_items(items, n, nthreads);
+    for (size_t i = 0; i < n; i++)
+        v[i] = (a_string_view){.data = items[i].data, .len = items[i].len};
+    free(items);
+}
+
+void a_strsort_astrs(a_string* v, size_t n, size_t nthreads) {
+    if (v == NULL && n != 0)
+        panic("cannot sort a null array!");
+
+    sort_item* items = items_alloc(n);
+    for (size_t i = 0; i < n; i++) {
+        if (!a_string_valid(&v[i]))
+            panic("string %zu is invalid!", i);
+        items[i] = (sort_item){.data = v[i].data, .len = v[i].len, .idx = i};
+    }
+    sort_items(items, n, nthreads);
+
+    a_string* tmp = malloc((n ? n : 1) * sizeof(a_string));
+    check_alloc(tmp);
+    for (size_t i = 0; i < n; i++)
+        tmp[i] = v[items[i].idx];
+    memcpy(v, tmp, n * sizeof(a_string));
+    free(tmp);
+    free(items);
+}
+
+void a_strsort_strvec(a_strvec* v, size_t nthreads) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+
+    size_t n = v->len;
+    sort_item* items = items_alloc(n);
+    for (size_t i = 0; i < n; i++) {
+        a_strvec_slot slot = v->slots[i];
+        items[i] = (sort_item){
+            .data = &v->bytes[slot.off],
+            .len = slot.len,
+            .idx = slot.off,
+        };
+    }
+    sort_items(items, n, nthreads);
+    for (size_t i = 0; i < n; i++)
+        v->slots[i] = (a_strvec_slot){.off = items[i].idx, .len = items[i].len};
+    free(items);
+}
@@ -0,0 +1,59 @@
+/*
+ * a_strsort: fast lexicographic sorting of string collections.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_STRSORT_H
+#define _A_STRSORT_H
+
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+#include "a_strvec.h"
+
+/*
+ * every sort orders strings bytewise, like memcmp with the shorter string
+ * first on a tie, so embedded null bytes are fine. None of them are stable.
+ *
+ * the sort is a multikey quicksort over 8 bytes at a time: each string's
+ * next 8 bytes are loaded once per level and cached next to it, so
+ * partitioning compares integers instead of chasing pointers, and shared
+ * prefixes are skipped a word at a time. Small buckets use insertion sort.
+ *
+ * `nthreads` of 1 sorts on the calling thread, and 0 uses one thread per
+ * online CPU. With more than one thread, the strings are first split by their
+ * first byte and the buckets are sorted concurrently. Small inputs are always
+ * sorted on the calling thread.
+ */
+
+/**
+ * sorts an array of views in place.
+ *
+ * @param v the views
+ * @param n the number of views
+ * @param nthreads number of threads to use
+ */
+void a_strsort_views(a_string_view* v, size_t n, size_t nthreads);
+
+/**
+ * sorts an array of a_strings in place. Only the structs move, never the
+ * string data.
+ *
+ * @param v the strings
+ * @param n the number of strings
+ * @param nthreads number of threads to use
+ */
+void a_strsort_astrs(a_string* v, size_t n, size_t nthreads);
+
+/**
+ * sorts the strings of an a_strvec. Only the slot table is reordered.
+ *
+ * @param nthreads number of threads to use
+ */
+void a_strsort_strvec(a_strvec* v, size_t nthreads);
+
+#endif // _A_STRSORT_H
@@ -0,0 +1,186 @@
+/*
+ * a_strvec: a vector of strings packed into one contiguous buffer.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "a_common.h"
+#include "a_strvec.h"
+
+static a_strvec strvec_invalid(void) {
+    return (a_strvec){
+        .bytes = NULL,
+        .bytes_len = (size_t)-1,
+        .bytes_cap = (size_t)-1,
+        .slots = NULL,
+        .len = (size_t)-1,
+        .cap = (size_t)-1,
+    };
+}
+
+a_strvec a_strvec_new(void) { return a_strvec_with_capacity(8, 64); }
+
+a_strvec a_strvec_with_capacity(size_t nstrings, size_t nbytes) {
+    a_strvec res = {
+        .bytes_len = 0,
+        .bytes_cap = nbytes ? nbytes : 1,
+        .len = 0,
+        .cap = nstrings ? nstrings : 1,
+    };
+
+    res.bytes = malloc(res.bytes_cap);
+    check_alloc(res.bytes);
+    res.slots = malloc(res.cap * sizeof(a_strvec_slot));
+    check_alloc(res.slots);
+    return res;
+}
+
+void a_strvec_free(a_strvec* v) {
+    if (!a_strvec_valid(v))
+        return;
+
+    free(v->bytes);
+    free(v->slots);
+    *v = strvec_invalid();
+}
+
+bool a_strvec_valid(const a_strvec* v) {
+    return !(v->len == (size_t)-1 || v->bytes == NULL || v->slots == NULL);
+}
+
+void a_strvec_clear(a_strvec* v) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+
+    v->len = 0;
+    v->bytes_len = 0;
+}
+
+void a_strvec_reserve(a_strvec* v, size_t nstrings, size_t nbytes) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+
+    // every string also takes a null terminator.
+    size_t need_bytes = v->bytes_len + nbytes + nstrings;
+    if (need_bytes > v->bytes_cap) {
+        size_t cap = v->bytes_cap;
+        while (cap < need_bytes)
+            cap *= 2;
+        v->bytes = realloc(v->bytes, cap);
+        check_alloc(v->bytes);
+        v->bytes_cap = cap;
+    }
+
+    size_t need_slots = v->len + nstrings;
+    if (need_slots > v->cap) {
+        size_t cap = v->cap;
+        while (cap < need_slots)
+            cap *= 2;
+        v->slots = realloc(v->slots, cap * sizeof(a_strvec_slot));
+        check_alloc(v->slots);
+        v->cap = cap;
+    }
+}
+
+void a_strvec_push(a_strvec* v, a_string_view s) {
+    if (s.data == NULL && s.len != 0)
+        panic("cannot push a null view!");
+
+    // the view may point into our own bytes (e.g. re-pushing a string from
+    // a_strvec_get), which the reserve below can move.
+    uintptr_t src = (uintptr_t)s.data;
+    uintptr_t base = (uintptr_t)v->bytes;
+    bool inside = s.len > 0 && src >= base && src < base + v->bytes_len;
+
+    a_strvec_reserve(v, 1, s.len);
+    if (inside)
+        s.data = &v->bytes[src - base];
+    if (s.len > 0)
+        memcpy(&v->bytes[v->bytes_len], s.data, s.len);
+    v->bytes[v->bytes_len + s.len] = '\0';
+    v->slots[v->len++] = (a_strvec_slot){.off = v->bytes_len, .len = s.len};
+    v->bytes_len += s.len + 1;
+}
+
+void a_strvec_push_cstr(a_strvec* v, const char* s) {
+    if (s == NULL)
+        panic("source C string is null!");
+
+    a_strvec_push(v, a_sv(s));
+}
+
+void a_strvec_push_astr(a_strvec* v, const a_string* s) {
+    if (!a_string_valid(s))
+        panic("source string is invalid!");
+
+    a_strvec_push(v, a_string_as_view(s));
+}
+
+a_string_view a_strvec_get(const a_strvec* v, size_t i) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+    if (i >= v->len)
+        panic("string index %zu out of range", i);
+
+    a_strvec_slot slot = v->slots[i];
+    return (a_string_view){.data = &v->bytes[slot.off], .len = slot.len};
+}
+
+a_strvec_iter a_strvec_iter_new(const a_strvec* v) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+
+    return (a_strvec_iter){.v = v, .pos = 0};
+}
+
+bool a_strvec_next(a_strvec_iter* it, a_string_view* out) {
+    if (it->pos >= it->v->len)
+        return false;
+
+    a_strvec_slot slot = it->v->slots[it->pos++];
+    *out = (a_string_view){.data = &it->v->bytes[slot.off], .len = slot.len};
+    return true;
+}
+
+a_strvec a_strvec_from_vector(const a_vector_a_string* src) {
+    if (src->len == (size_t)-1 || src->data == NULL)
+        panic("the vector is invalid");
+
+    // size everything up front, so the copy is a single pass.
+    size_t nbytes = 0;
+    for (size_t i = 0; i < src->len; i++) {
+        if (!a_string_valid(&src->data[i]))
+            panic("string %zu of the vector is invalid!", i);
+        nbytes += src->data[i].len;
+    }
+
+    a_strvec res = a_strvec_with_capacity(src->len, nbytes + src->len);
+    for (size_t i = 0; i < src->len; i++)
+        a_strvec_push(&res, a_string_as_view(&src->data[i]));
+    return res;
+}
+
+a_vector_a_string a_strvec_to_vector(const a_strvec* v) {
+    if (!a_strvec_valid(v))
+        panic("cannot operate on an invalid a_strvec!");
+
+    size_t cap = v->len ? v->len : 1;
+    a_vector_a_string res = a_vector_a_string_with_capacity(cap);
+    for (size_t i = 0; i < v->len; i++) {
+        a_strvec_slot slot = v->slots[i];
+        a_string s = a_string_with_capacity(slot.len + 1);
+        check_alloc(s.data);
+        memcpy(s.data, &v->bytes[slot.off], slot.len + 1);
+        s.len = slot.len;
+        res.data[res.len++] = s;
+    }
+    return res;
+}
@@ -0,0 +1,154 @@
+/*
+ * a_strvec: a vector of strings packed into one contiguous buffer.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_STRVEC_H
+#define _A_STRVEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+/**
+ * location of one string inside an a_strvec's byte buffer.
+ */
+typedef struct {
+    // offset of the first byte.
+    size_t off;
+
+    // length of the string, without the null terminator.
+    size_t len;
+} a_strvec_slot;
+
+/**
+ * vector of immutable strings that share one growable byte buffer.
+ *
+ * strings are stored back to back, each followed by a null terminator, and
+ * found through a table of slots. Compared to an `a_vector_a_string`, there
+ * is no per-string allocation, and walking the strings in order walks memory
+ * in order. Reordering the slots (e.g. when sorting) never moves the bytes.
+ *
+ * views handed out by `a_strvec_get` are invalidated by the next push.
+ */
+typedef struct {
+    // the packed, null terminated strings.
+    char* bytes;
+
+    // number of bytes in use.
+    size_t bytes_len;
+
+    // capacity of the byte buffer.
+    size_t bytes_cap;
+
+    // where each string lives in `bytes`.
+    a_strvec_slot* slots;
+
+    // number of strings.
+    size_t len;
+
+    // capacity of the slot table.
+    size_t cap;
+} a_strvec;
+
+/**
+ * iterator over the strings of an a_strvec. Create one with
+ * `a_strvec_iter_new` and advance it with `a_strvec_next`.
+ */
+typedef struct {
+    // the vector being iterated over.
+    const a_strvec* v;
+
+    // index of the next string.
+    size_t pos;
+} a_strvec_iter;
+
+/**
+ * creates an empty a_strvec.
+ */
+a_strvec a_strvec_new(void);
+
+/**
+ * creates an empty a_strvec with room for a number of strings and bytes.
+ *
+ * @param nstrings number of strings to make room for
+ * @param nbytes total length of the strings to make room for
+ */
+a_strvec a_strvec_with_capacity(size_t nstrings, size_t nbytes);
+
+/**
+ * frees the buffer and every string in it at once.
+ */
+void a_strvec_free(a_strvec* v);
+
+/**
+ * checks if an a_strvec is valid.
+ */
+bool a_strvec_valid(const a_strvec* v);
+
+/**
+ * removes every string, but keeps the memory around.
+ */
+void a_strvec_clear(a_strvec* v);
+
+/**
+ * makes sure that a number of strings with a total length can be pushed
+ * without reallocating.
+ *
+ * @param nstrings number of strings about to be pushed
+ * @param nbytes total length of those strings
+ */
+void a_strvec_reserve(a_strvec* v, size_t nstrings, size_t nbytes);
+
+/**
+ * copies a run of bytes into the vector as a new string. The view may point
+ * into the vector itself.
+ */
+void a_strvec_push(a_strvec* v, a_string_view s);
+
+/**
+ * copies a null terminated C string into the vector.
+ */
+void a_strvec_push_cstr(a_strvec* v, const char* s);
+
+/**
+ * copies an a_string into the vector.
+ */
+void a_strvec_push_astr(a_strvec* v, const a_string* s);
+
+/**
+ * gets a view of a string in the vector. The view is null terminated.
+ *
+ * @param i index of the string
+ */
+a_string_view a_strvec_get(const a_strvec* v, size_t i);
+
+/**
+ * creates an iterator over the strings of an a_strvec.
+ */
+a_strvec_iter a_strvec_iter_new(const a_strvec* v);
+
+/**
+ * gets the next string of an iterator.
+ *
+ * @param out where to store the string
+ * @return false once every string has been visited
+ */
+bool a_strvec_next(a_strvec_iter* it, a_string_view* out);
+
+/**
+ * copies a vector of a_strings into a new a_strvec.
+ */
+a_strvec a_strvec_from_vector(const a_vector_a_string* src);
+
+/**
+ * copies every string of an a_strvec into a new vector of a_strings.
+ */
+a_vector_a_string a_strvec_to_vector(const a_strvec* v);
+
+#endif // _A_STRVEC_H
@@ -31,9 +31,23 @@
     void a_vector_##T##_append_slice(a_vector_##T* v, const T* ptr,            \
                                      size_t nitems);                           \
     T a_vector_##T##_pop(a_vector_##T* v);                                     \
-    T a_vector_##T##_pop_at(a_vector_##T* v, size_t pos);
+    T a_vector_##T##_pop_at(a_vector_##T* v, size_t pos);                      \
+    a_vector_##T a_vector_##T##_take(a_vector_##T* v);                         \
+    T* a_vector_##T##_into_raw(a_vector_##T* v, size_t* len, size_t* cap);     \
+    a_vector_##T a_vector_##T##_from_raw(T* data, size_t len, size_t cap);
 #define A_VECTOR_GROWTH_FACTOR 3
-#define A_VECTOR_IMPL(T)                                                       \
+
+// drop hook that does nothing, for vectors of plain values.
+#define A_VECTOR_NO_DROP(elem) ((void)(elem))
+
+/*
+ * implements a vector whose elements own resources. `drop_fn` is called with a
+ * pointer to every element still in the vector when it is freed, e.g.
+ * `A_VECTOR_IMPL_DROP(a_string, a_string_free)`. Elements that leave the
+ * vector through pop/pop_at are owned by the caller and are not dropped.
+ */
+#define A_VECTOR_IMPL(T) A_VECTOR_IMPL_DROP(T, A_VECTOR_NO_DROP)
+#define A_VECTOR_IMPL_DROP(T, drop_fn)                                         \
     a_vector_##T a_vector_##T##_new(void) {                                    \
         return a_vector_##T##_with_capacity(5);                                \
     }                                                                          \
@@ -50,7 +64,12 @@
         return res;                                                            \
     }                                                                          \
     void a_vector_##T##_free(a_vector_##T* v) {                                \
+        if (a_vector_##T##_valid(v)) {                                         \
+            for (size_t i = 0; i < v->len; i++)                                \
+                drop_fn(&v->data[i]);                                          \
+        }                                                                      \
         free(v->data);                                                         \
+        v->data = NULL;                                                        \
         v->len = (size_t)-1;                                                   \
         v->cap = (size_t)-1;                                                   \
     }                                                                          \
@@ -127,6 +146,185 @@
         memmove(&v->data[pos], &v->data[pos + 1], items * sizeof(T));          \
         v->len--;                                                              \
         return res;                                                            \
+    }                                                                          \
+    a_vector_##T a_vector_##T##_take(a_vector_##T* v) {                        \
+        a_vector_##T res = *v;                                                 \
+        v->data = NULL;                                                        \
+        v->len = (size_t)-1;                                                   \
+        v->cap = (size_t)-1;                                                   \
+        return res;                                                            \
+    }                                                                          \
+    T* a_vector_##T##_into_raw(a_vector_##T* v, size_t* len, size_t* cap) {    \
+        if (!a_vector_##T##_valid(v)) {                                        \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        T* data = v->data;                                                     \
+        if (len)                                                               \
+            *len = v->len;                                                     \
+        if (cap)                                                               \
+            *cap = v->cap;                                                     \
+        a_vector_##T##_take(v);                                                \
+        return data;                                                           \
+    }                                                                          \
+    a_vector_##T a_vector_##T##_from_raw(T* data, size_t len, size_t cap) {    \
+        if (data == NULL) {                                                    \
+            panic("cannot build a vector from a null buffer");                 \
+        }                                                                      \
+        if (len > cap) {                                                       \
+            panic("length %zu exceeds capacity %zu", len, cap);                \
+        }                                                                      \
+        return (a_vector_##T){.data = data, .len = len, .cap = cap};           \
     }
 
+/*
+ * a vector whose buffer always starts on an `A` byte boundary, e.g. 64 for a
+ * cache line or AVX-512 register. `A` must be a power of 2 and at least the
+ * alignment of `T`. Growing allocates a new aligned buffer and copies into
+ * it, since there is no aligned realloc.
+ *
+ *     A_VECTOR_DECL_ALIGNED(f32, 64);      // declares a_alignvec_f32
+ *     A_VECTOR_IMPL_ALIGNED(f32, 64)
+ */
+#define A_VECTOR_DECL_ALIGNED(T, A)                                            \
+    _Static_assert((A) > 0 && ((A) & ((A) - 1)) == 0,                          \
+                   "alignment must be a power of 2");                          \
+    _Static_assert((A) >= _Alignof(T), "alignment is below that of the type"); \
+    typedef struct {                                                           \
+        T* data;                                                               \
+        size_t len;                                                            \
+        size_t cap;                                                            \
+    } a_alignvec_##T;                                                          \
+    a_alignvec_##T a_alignvec_##T##_new(void);                                 \
+    a_alignvec_##T a_alignvec_##T##_with_capacity(size_t cap);                 \
+    a_alignvec_##T a_alignvec_##T##_from_slice(const T* slice,                 \
+                                               size_t nitems);                 \
+    void a_alignvec_##T##_free(a_alignvec_##T* v);                             \
+    bool a_alignvec_##T##_valid(const a_alignvec_##T* v);                      \
+    void a_alignvec_##T##_reserve(a_alignvec_##T* v, size_t cap);              \
+    void a_alignvec_##T##_append(a_alignvec_##T* v, T new_elem);               \
+    void a_alignvec_##T##_append_slice(a_alignvec_##T* v, const T* ptr,        \
+                                       size_t nitems);                         \
+    T a_alignvec_##T##_pop(a_alignvec_##T* v);                                 \
+    T a_alignvec_##T##_pop_at(a_alignvec_##T* v, size_t pos)
+
+#define A_VECTOR_IMPL_ALIGNED(T, A)                                            \
+    A_VECTOR_IMPL_ALIGNED_DROP(T, A, A_VECTOR_NO_DROP)
+#define A_VECTOR_IMPL_ALIGNED_DROP(T, A, drop_fn)                              \
+    static T* a_alignvec_##T##_alloc(size_t cap) {                             \
+        size_t bytes = sizeof(T) * (cap ? cap : 1);                            \
+        bytes = (bytes + (A) - 1) & ~(size_t)((A) - 1);                        \
+        T* data = aligned_alloc((A), bytes);                                   \
+        check_alloc(data);                                                     \
+        return data;                                                           \
+    }                                                                          \
+    a_alignvec_##T a_alignvec_##T##_new(void) {                                \
+        return a_alignvec_##T##_with_capacity(5);                              \
+    }                                                                          \
+    a_alignvec_##T a_alignvec_##T##_with_capacity(size_t cap) {                \
+        if (cap == 0)                                                          \
+            cap = 1;                                                           \
+        a_alignvec_##T res = {.len = 0, .cap = cap};                           \
+        res.data = a_alignvec_##T##_alloc(cap);                                \
+        memset(res.data, 0, sizeof(T) * cap);                                  \
+        return res;                                                            \
+    }                                                                          \
+    a_alignvec_##T a_alignvec_##T##_from_slice(const T* slice,                 \
+                                               size_t nitems) {                \
+        a_alignvec_##T res = a_alignvec_##T##_with_capacity(nitems);           \
+        memcpy(res.data, slice, nitems * sizeof(T));                           \
+        res.len = nitems;                                                      \
+        return res;                                                            \
+    }                                                                          \
+    void a_alignvec_##T##_free(a_alignvec_##T* v) {                            \
+        if (a_alignvec_##T##_valid(v)) {                                       \
+            for (size_t i = 0; i < v->len; i++)                                \
+                drop_fn(&v->data[i]);                                          \
+        }                                                                      \
+        free(v->data);                                                         \
+        v->data = NULL;                                                        \
+        v->len = (size_t)-1;                                                   \
+        v->cap = (size_t)-1;                                                   \
+    }                                                                          \
+    bool a_alignvec_##T##_valid(const a_alignvec_##T* v) {                     \
+        return !(v->len == (size_t)-1 || v->cap == (size_t)-1 ||               \
+                 v->data == NULL);                                             \
+    }                                                                          \
+    void a_alignvec_##T##_reserve(a_alignvec_##T* v, size_t cap) {             \
+        if (!a_alignvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (cap < v->len) {                                                    \
+            panic("capacity %zu is below the length %zu", cap, v->len);        \
+        }                                                                      \
+        T* data = a_alignvec_##T##_alloc(cap);                                 \
+        memcpy(data, v->data, sizeof(T) * v->len);                             \
+        free(v->data);                                                         \
+        v->data = data;                                                        \
+        v->cap = cap;                                                          \
+    }                                                                          \
+    void a_alignvec_##T##_append(a_alignvec_##T* v, T new_elem) {              \
+        if (!a_alignvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (v->len + 1 > v->cap) {                                             \
+            a_alignvec_##T##_reserve(v, v->cap * A_VECTOR_GROWTH_FACTOR);      \
+        }                                                                      \
+        v->data[v->len++] = new_elem;                                          \
+    }                                                                          \
+    void a_alignvec_##T##_append_slice(a_alignvec_##T* v, const T* data,       \
+                                       size_t nitems) {                        \
+        if (!a_alignvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        size_t len = v->len + nitems;                                          \
+        if (len > v->cap) {                                                    \
+            size_t sz = v->cap;                                                \
+            while (sz < len)                                                   \
+                sz *= A_VECTOR_GROWTH_FACTOR;                                  \
+            a_alignvec_##T##_reserve(v, sz);                                   \
+        }                                                                      \
+        memcpy(&v->data[v->len], data, sizeof(T) * nitems);                    \
+        v->len += nitems;                                                      \
+    }                                                                          \
+    T a_alignvec_##T##_pop(a_alignvec_##T* v) {                                \
+        if (!a_alignvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (v->len == 0) {                                                     \
+            panic("cannot pop from an empty vector");                          \
+        }                                                                      \
+        return v->data[--v->len];                                              \
+    }                                                                          \
+    T a_alignvec_##T##_pop_at(a_alignvec_##T* v, size_t pos) {                 \
+        if (!a_alignvec_##T##_valid(v)) {                                      \
+            panic("the vector is invalid");                                    \
+        }                                                                      \
+        if (pos >= v->len) {                                                   \
+            panic("array index %zu out of range", pos);                        \
+        }                                                                      \
+        T res = v->data[pos];                                                  \
+        size_t items = (v->len - pos - 1);                                     \
+        memmove(&v->data[pos], &v->data[pos + 1], items * sizeof(T));          \
+        v->len--;                                                              \
+        return res;                                                            \
+    }
+
+/*
+ * an aligned vector where every element takes up a whole `A` byte block,
+ * wrapped in `a_padded_T`. With `A` set to the cache line size, threads that
+ * each update their own element never share a cache line, e.g. for per-thread
+ * counters:
+ *
+ *     A_VECTOR_DECL_PADDED(u64, 64);       // declares a_padded_u64 and
+ *     A_VECTOR_IMPL_PADDED(u64, 64)        // a_alignvec_a_padded_u64
+ *
+ *     counters.data[thread_id].value++;
+ */
+#define A_VECTOR_DECL_PADDED(T, A)                                             \
+    typedef struct {                                                           \
+        _Alignas(A) T value;                                                   \
+    } a_padded_##T;                                                            \
+    A_VECTOR_DECL_ALIGNED(a_padded_##T, A)
+#define A_VECTOR_IMPL_PADDED(T, A) A_VECTOR_IMPL_ALIGNED(a_padded_##T, A)
+
 #endif // _A_VECTOR_H
@@ -0,0 +1,175 @@
+/*
+ * a_writer: buffered output straight to a file descriptor.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "a_common.h"
+#include "a_writer.h"
+
+a_writer a_writer_new(int fd) {
+    return a_writer_with_capacity(fd, A_WRITER_DEFAULT_CAP);
+}
+
+a_writer a_writer_with_capacity(int fd, size_t cap) {
+    if (cap == 0)
+        panic("a writer needs a buffer of at least 1 byte!");
+
+    a_writer res = {.fd = fd, .len = 0, .cap = cap, .err = 0};
+    res.buf = malloc(cap);
+    check_alloc(res.buf);
+    return res;
+}
+
+bool a_writer_free(a_writer* w) {
+    if (!a_writer_valid(w))
+        return true;
+
+    bool ok = a_writer_flush(w);
+    free(w->buf);
+    w->buf = NULL;
+    w->len = (size_t)-1;
+    w->cap = (size_t)-1;
+    return ok;
+}
+
+bool a_writer_valid(const a_writer* w) {
+    return !(w->len == (size_t)-1 || w->cap == (size_t)-1 || w->buf == NULL);
+}
+
+// writes out every byte of up to 2 iovecs, retrying on short writes.
+static bool write_all(a_writer* w, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(w->fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            w->err = errno;
+            return false;
+        }
+
+        size_t done = (size_t)n;
+        while (iovcnt > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+bool a_writer_write(a_writer* w, const char* data, size_t len) {
+    if (!a_writer_valid(w))
+        panic("cannot operate on an invalid a_writer!");
+    if (w->err != 0)
+        return false;
+
+    if (len <= w->cap - w->len) {
+        memcpy(&w->buf[w->len], data, len);
+        w->len += len;
+        return true;
+    }
+
+    if (len < w->cap) {
+        if (!a_writer_flush(w))
+            return false;
+        memcpy(w->buf, data, len);
+        w->len = len;
+        return true;
+    }
+
+    // too big to be worth buffering: send the buffer and the data together,
+    // without copying the data.
+    struct iovec iov[2] = {
+        {.iov_base = w->buf, .iov_len = w->len},
+        {.iov_base = (void*)data, .iov_len = len},
+    };
+    bool ok = (w->len == 0) ? write_all(w, &iov[1], 1) : write_all(w, iov, 2);
+    w->len = 0;
+    return ok;
+}
+
+bool a_writer_write_view(a_writer* w, a_string_view v) {
+    return a_writer_write(w, v.data, v.len);
+}
+
+bool a_writer_write_astr(a_writer* w, const a_string* s) {
+    if (!a_string_valid(s))
+        panic("cannot operate on an invalid a_string!");
+
+    return a_writer_write(w, s->data, s->len);
+}
+
+bool a_writer_write_cstr(a_writer* w, const char* cstr) {
+    if (cstr == NULL)
+        panic("null string passed to write operation!");
+
+    return a_writer_write(w, cstr, strlen(cstr));
+}
+
+bool a_writer_write_char(a_writer* w, char c) {
+    if (a_writer_valid(w) && w->len < w->cap && w->err == 0) {
+        w->buf[w->len++] = c;
+        return true;
+    }
+    return a_writer_write(w, &c, 1);
+}
+
+bool a_writer_write_i64(a_writer* w, i64 value) {
+    char buf[A_STRING_INT_MAX_CHARS];
+    return a_writer_write_view(w, a_string_fmt_i64(buf, value));
+}
+
+bool a_writer_write_u64(a_writer* w, u64 value) {
+    char buf[A_STRING_INT_MAX_CHARS];
+    return a_writer_write_view(w, a_string_fmt_u64(buf, value));
+}
+
+bool a_writer_write_hex(a_writer* w, u64 value) {
+    char buf[A_STRING_HEX_MAX_CHARS];
+    return a_writer_write_view(w, a_string_fmt_hex(buf, value));
+}
+
+bool a_writer_write_f64(a_writer* w, f64 value) {
+    char buf[A_STRING_F64_MAX_CHARS];
+    return a_writer_write_view(w, a_string_fmt_f64(buf, value));
+}
+
+bool a_writer_flush(a_writer* w) {
+    if (!a_writer_valid(w))
+        panic("cannot operate on an invalid a_writer!");
+    if (w->err != 0)
+        return false;
+    if (w->len == 0)
+        return true;
+
+    struct iovec iov = {.iov_base = w->buf, .iov_len = w->len};
+    bool ok = write_all(w, &iov, 1);
+    w->len = 0;
+    return ok;
+}
+
+bool a_writer_sync(a_writer* w) {
+    if (!a_writer_flush(w))
+        return false;
+
+    if (fsync(w->fd) != 0) {
+        w->err = errno;
+        return false;
+    }
+    return true;
+}
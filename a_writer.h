@@ -0,0 +1,179 @@
+/*
+ * a_writer: buffered output straight to a file descriptor.
+ *
+ * Copyright (c) Eason Qin, 2025.
+ *
+ * This source code form is licensed under the MIT/Expat license.
+ * Visit the OSI website for a digital version.
+ */
+#ifndef _A_WRITER_H
+#define _A_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "a_common.h"
+#include "a_string.h"
+
+// default size of an a_writer's buffer.
+#define A_WRITER_DEFAULT_CAP (64 * 1024)
+
+/**
+ * buffered writer over a raw file descriptor.
+ *
+ * writes are collected in a user-space buffer and handed to the kernel with
+ * `write`/`writev` once it fills up, or on an explicit flush. Unlike stdio,
+ * there is no locking and no format parsing. Writes that are at least as big
+ * as the buffer skip it and go out directly.
+ *
+ * errors are sticky: after the first failed write, every operation fails and
+ * `err` holds the errno value.
+ */
+typedef struct {
+    // the target file descriptor. It is not owned by the writer.
+    int fd;
+
+    // the buffered, not yet written bytes.
+    char* buf;
+
+    // number of bytes in the buffer.
+    size_t len;
+
+    // capacity of the buffer.
+    size_t cap;
+
+    // errno value of the first failed write, or 0.
+    int err;
+} a_writer;
+
+/**
+ * creates a writer with a buffer of `A_WRITER_DEFAULT_CAP` bytes.
+ *
+ * @param fd the file descriptor to write to
+ */
+a_writer a_writer_new(int fd);
+
+/**
+ * creates a writer with a buffer of a specific size.
+ *
+ * @param fd the file descriptor to write to
+ * @param cap the capacity of the buffer
+ */
+a_writer a_writer_with_capacity(int fd, size_t cap);
+
+/**
+ * flushes a writer and frees its buffer. The file descriptor is left open.
+ *
+ * @param w the writer
+ * @return false if the final flush failed
+ */
+bool a_writer_free(a_writer* w);
+
+/**
+ * checks if a writer is valid.
+ *
+ * @param w the writer
+ */
+bool a_writer_valid(const a_writer* w);
+
+/**
+ * writes bytes through a writer.
+ *
+ * @param w the writer
+ * @param data the bytes
+ * @param len the number of bytes
+ * @return false on error
+ */
+bool a_writer_write(a_writer* w, const char* data, size_t len);
+
+/**
+ * writes a view through a writer.
+ *
+ * @param w the writer
+ * @param v the view
+ * @return false on error
+ */
+bool a_writer_write_view(a_writer* w, a_string_view v);
+
+/**
+ * writes an a_string through a writer.
+ *
+ * @param w the writer
+ * @param s the string
+ * @return false on error
+ */
+bool a_writer_write_astr(a_writer* w, const a_string* s);
+
+/**
+ * writes a C string through a writer.
+ *
+ * @param w the writer
+ * @param cstr the C string
+ * @return false on error
+ */
+bool a_writer_write_cstr(a_writer* w, const char* cstr);
+
+/**
+ * writes a single character through a writer.
+ *
+ * @param w the writer
+ * @param c the character
+ * @return false on error
+ */
+bool a_writer_write_char(a_writer* w, char c);
+
+/**
+ * writes a signed integer in decimal through a writer.
+ *
+ * @param w the writer
+ * @param value the value
+ * @return false on error
+ */
+bool a_writer_write_i64(a_writer* w, i64 value);
+
+/**
+ * writes an unsigned integer in decimal through a writer.
+ *
+ * @param w the writer
+ * @param value the value
+ * @return false on error
+ */
+bool a_writer_write_u64(a_writer* w, u64 value);
+
+/**
+ * writes an unsigned integer in lowercase hex through a writer.
+ *
+ * @param w the writer
+ * @param value the value
+ * @return false on error
+ */
+bool a_writer_write_hex(a_writer* w, u64 value);
+
+/**
+ * writes the shortest round-trip representation of a double through a
+ * writer. see `a_string_fmt_f64` for the format.
+ *
+ * @param w the writer
+ * @param value the value
+ * @return false on error
+ */
+bool a_writer_write_f64(a_writer* w, f64 value);
+
+/**
+ * hands all buffered bytes to the kernel.
+ *
+ * @param w the writer
+ * @return false on error
+ */
+bool a_writer_flush(a_writer* w);
+
+/**
+ * flushes a writer, then waits for the data to reach the storage device with
+ * `fsync`.
+ *
+ * @param w the writer
+ * @return false on error
+ */
+bool a_writer_sync(a_writer* w);
+
+#endif // _A_WRITER_H